@@ -0,0 +1,164 @@
+#include "Atom.h"
+#include "String.h"
+#include <ostream>
+#include <cstring>
+
+// A table entry holds the text, its hash code, the number of Atoms that refer to it,
+// and the next entry in the same hash chain.
+struct Atom::Entry {
+    Entry(const String& text_, unsigned int hash_) :
+        text(text_), hash(hash_), references(1), next(nullptr)
+        {}
+    String text;
+    unsigned int hash;
+    int references;
+    Entry* next;
+};
+
+Atom::Entry** Atom::buckets = nullptr;
+int Atom::bucket_count = 0;
+int Atom::entry_count = 0;
+
+// Create an Atom for the supplied text, adding the text to the table if it is not there
+Atom::Atom(const String& text) :
+    entry(intern(text))
+{
+}
+
+// Copies refer to the same table entry
+Atom::Atom(const Atom& original) :
+    entry(original.entry)
+{
+    if (entry != nullptr)
+    {
+        entry->references++;
+    }
+}
+
+// Move construction takes the original's entry, leaving the original empty
+Atom::Atom(Atom&& original) noexcept :
+    entry(original.entry)
+{
+    original.entry = nullptr;
+}
+
+Atom::~Atom() noexcept
+{
+    release(entry);
+}
+
+Atom& Atom::operator= (const Atom& rhs)
+{
+    Atom temp(rhs);
+    swap(temp);
+    return *this;
+}
+
+Atom& Atom::operator= (Atom&& rhs) noexcept
+{
+    swap(rhs);
+    return *this;
+}
+
+// Return a pointer to the C-string of the text
+const char* Atom::c_str() const
+{
+    return (entry != nullptr) ? entry->text.c_str() : "";
+}
+
+// Return the length of the text
+int Atom::size() const
+{
+    return (entry != nullptr) ? entry->text.size() : 0;
+}
+
+void Atom::swap(Atom& other) noexcept
+{
+    Entry* temp = entry;
+    entry = other.entry;
+    other.entry = temp;
+}
+
+// Return the entry for the text with one more reference, creating it if necessary.
+// Empty text has no entry.
+Atom::Entry* Atom::intern(const String& text)
+{
+    if (text.size() == 0)
+    {
+        return nullptr;
+    }
+    unsigned int hash = text.get_hash();
+    if (bucket_count > 0)
+    {
+        for (Entry* e = buckets[hash & (bucket_count - 1)]; e != nullptr; e = e->next)
+        {
+            if (e->hash == hash && e->text == text)
+            {
+                e->references++;
+                return e;
+            }
+        }
+    }
+    if (entry_count >= bucket_count)
+    {
+        grow_table();
+    }
+    Entry* new_entry = new Entry(text, hash);
+    Entry*& bucket = buckets[hash & (bucket_count - 1)];
+    new_entry->next = bucket;
+    bucket = new_entry;
+    entry_count++;
+    return new_entry;
+}
+
+// Drop a reference to the entry, destroying it when no references remain;
+// the table itself is deallocated when its last entry is removed.
+void Atom::release(Entry* entry) noexcept
+{
+    if (entry == nullptr || --entry->references > 0)
+    {
+        return;
+    }
+    Entry** link = &buckets[entry->hash & (bucket_count - 1)];
+    while (*link != entry)
+    {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    delete entry;
+    if (--entry_count == 0)
+    {
+        delete[] buckets;
+        buckets = nullptr;
+        bucket_count = 0;
+    }
+}
+
+// Double the number of buckets (starting with 16) and move the entries into the new chains
+void Atom::grow_table()
+{
+    int new_count = (bucket_count == 0) ? 16 : 2 * bucket_count;
+    Entry** new_buckets = new Entry*[new_count]();
+    for (int i = 0; i < bucket_count; i++)
+    {
+        Entry* e = buckets[i];
+        while (e != nullptr)
+        {
+            Entry* next = e->next;
+            Entry*& bucket = new_buckets[e->hash & (new_count - 1)];
+            e->next = bucket;
+            bucket = e;
+            e = next;
+        }
+    }
+    delete[] buckets;
+    buckets = new_buckets;
+    bucket_count = new_count;
+}
+
+// The output operator writes the text of the Atom to the stream
+std::ostream& operator<< (std::ostream& os, const Atom& atom)
+{
+    os << atom.c_str();
+    return os;
+}
@@ -0,0 +1,68 @@
+#ifndef ATOM_H
+#define ATOM_H
+
+#include "String.h"
+#include <ostream>
+
+/*
+An Atom is a handle to a shared, immutable piece of text kept in an intern table.
+Atoms created from equal text share a single String in the table, so a value that is
+repeated in many objects (such as the medium of a Record) is stored only once, and two
+Atoms can be compared for equality in constant time by comparing their table entries.
+
+Each table entry counts the Atoms that refer to it, and is removed from the table and
+destroyed when the last of them is destroyed, so the table holds only text that is in use.
+A default-constructed Atom has empty text and refers to no table entry.
+*/
+
+class Atom {
+public:
+    // Create an Atom with empty text
+    Atom() :
+        entry(nullptr)
+        {}
+    // Create an Atom for the supplied text, adding the text to the table if it is not there
+    explicit Atom(const String& text);
+    // Copies refer to the same table entry
+    Atom(const Atom& original);
+    // Move construction takes the original's entry, leaving the original empty
+    Atom(Atom&& original) noexcept;
+    ~Atom() noexcept;
+
+    Atom& operator= (const Atom& rhs);
+    Atom& operator= (Atom&& rhs) noexcept;
+
+    // Return a pointer to the C-string of the text
+    const char* c_str() const;
+    // Return the length of the text
+    int size() const;
+
+    // Atoms are equal if and only if their text is equal
+    bool operator== (const Atom& rhs) const
+        {return entry == rhs.entry;}
+    bool operator!= (const Atom& rhs) const
+        {return entry != rhs.entry;}
+
+    void swap(Atom& other) noexcept;
+
+    // Return the number of distinct texts in the table
+    static int get_table_size()
+        {return entry_count;}
+
+private:
+    struct Entry;
+    Entry* entry;
+
+    static Entry** buckets;     // hash table of chains of entries
+    static int bucket_count;    // a power of two, or 0 when the table is empty
+    static int entry_count;
+
+    static Entry* intern(const String& text);
+    static void release(Entry* entry) noexcept;
+    static void grow_table();
+};
+
+// The output operator writes the text of the Atom to the stream
+std::ostream& operator<< (std::ostream& os, const Atom& atom);
+
+#endif
@@ -7,6 +7,92 @@
 #include "Ordered_list.h"
 #include "String.h"
 
+namespace {
+
+// Reads the member titles of a Collection in save format for Ordered_list::deserialize,
+// and resolves each one to the Record with that title in the library. The titles are
+// read and looked up in batches so that the searches can be interleaved by find_many.
+class Member_reader {
+public:
+    Member_reader(std::ifstream& is_, const Ordered_list<Record*, Less_than_ptr<Record*>>& library_) :
+        is(is_), library(library_), remaining(0), batch(0), next(0)
+        {}
+
+    // Read the number of members; throw Error exception if it is missing
+    int read_count()
+    {
+        if (!(is >> remaining))
+        {
+            throw_file_error();
+        }
+        return remaining;
+    }
+
+    // Return the next member; throw Error exception if there is no Record with its title
+    Record* read()
+    {
+        if (next == batch)
+        {
+            read_batch();
+        }
+        auto record_it = results[next++];
+        if (record_it == library.end())
+        {
+            throw_file_error();
+        }
+        return *record_it;
+    }
+
+    // A member that could not be added is left alone; the Record belongs to the library
+    void discard(Record*)
+        {}
+
+private:
+    static const int batch_size = Ordered_list<Record*, Less_than_ptr<Record*>>::find_lanes;
+    std::ifstream& is;
+    const Ordered_list<Record*, Less_than_ptr<Record*>>& library;
+    int remaining;  // titles not yet read from the file
+    int batch;      // titles in the current batch
+    int next;       // next result in the current batch to return
+    String titles[batch_size];
+    String_view probes[batch_size];
+    Ordered_list<Record*, Less_than_ptr<Record*>>::Iterator results[batch_size];
+
+    void read_batch()
+    {
+        batch = remaining;
+        if (batch > batch_size) batch = batch_size;
+        for (int i = 0; i < batch; i++)
+        {
+            is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            getline(is, titles[i]);
+            probes[i] = String_view(titles[i]);
+        }
+        remaining -= batch;
+        library.find_many(probes, results, batch);
+        next = 0;
+    }
+};
+
+// Writes the member titles of a Collection in save format for Ordered_list::serialize
+class Member_writer {
+public:
+    Member_writer(std::ostream& os_) :
+        os(os_)
+        {}
+    void write_count(int n)
+    {
+        char count[String::max_int_chars + 1] = {' '};
+        os.write(count, 1 + String::format_int(count + 1, n));
+    }
+    void write(Record* record_ptr)
+        { os << "\n" << record_ptr->get_title(); }
+private:
+    std::ostream& os;
+};
+
+}
+
 /* Construct a Collection from an input file stream in save format, using the record list,
     restoring all the Record information.
     Record list is needed to resolve references to record members.
@@ -15,23 +101,45 @@
     String data input is read directly into the member variable. */
 Collection::Collection(std::ifstream& is, const Ordered_list<Record*, Less_than_ptr<Record*>>& library)
 {
-    int num;
-    if (!(is >> name >> num))
+    if (!(is >> name))
     {
         throw_file_error();
     }
-    for (int i = 0; i < num; i++)
+    name.shrink_to_fit();
+    Member_reader reader(is, library);
+    elements.deserialize(reader);
+    for (auto it = elements.begin(); it != elements.end(); ++it)
     {
-        is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        String title;
-        getline(is, title);
-        Record temp_record(title);
-        auto record_it = library.find(&temp_record);
-        if (record_it == library.end())
+        if (!member_IDs.insert((*it)->get_ID()))
         {
             throw_file_error();
         }
-        elements.insert(*record_it);
+    }
+    auto it = elements.begin();
+    try
+    {
+        for (; it != elements.end(); ++it)
+        {
+            (*it)->add_collection(this);
+            count_rating(*it, 1);
+        }
+    }
+    catch (...)
+    {
+        for (auto added = elements.begin(); added != it; ++added)
+        {
+            (*added)->remove_collection(this);
+        }
+        throw;
+    }
+}
+
+// Remove this Collection from its members' lists of Collections
+Collection::~Collection()
+{
+    for (auto it = elements.begin(); it != elements.end(); ++it)
+    {
+        (*it)->remove_collection(this);
     }
 }
 
@@ -42,12 +150,32 @@ void Collection::add_member(Record* record_ptr)
     {
         throw Error("Record is already a member in the collection!");
     }
-    elements.insert(record_ptr);
+    member_IDs.insert(record_ptr->get_ID());
+    try
+    {
+        record_ptr->add_collection(this);
+    }
+    catch (...)
+    {
+        member_IDs.erase(record_ptr->get_ID());
+        throw;
+    }
+    try
+    {
+        elements.insert(record_ptr);
+    }
+    catch (...)
+    {
+        record_ptr->remove_collection(this);
+        member_IDs.erase(record_ptr->get_ID());
+        throw;
+    }
+    count_rating(record_ptr, 1);
 }
 // Return true if the record is present, false if not.
 bool Collection::is_member_present(Record* record_ptr) const
 {
-    return elements.find(record_ptr) != elements.end();
+    return member_IDs.contains(record_ptr->get_ID());
 }
 // Remove the specified Record, throw exception if the record was not found.
 void Collection::remove_member(Record* record_ptr)
@@ -58,16 +186,55 @@ void Collection::remove_member(Record* record_ptr)
         throw Error("Record is not a member in the collection!");
     }
     elements.erase(it);
+    member_IDs.erase(record_ptr->get_ID());
+    record_ptr->remove_collection(this);
+    count_rating(record_ptr, -1);
 }
 
-// Write a Collection's data to a stream in save format, with endl as specified.
-void Collection::save(std::ostream& os) const
+// discard all members
+void Collection::clear()
 {
-    os << name << " " << elements.size();
     for (auto it = elements.begin(); it != elements.end(); ++it)
     {
-        os << "\n" << (*it)->get_title();
+        (*it)->remove_collection(this);
+    }
+    elements.clear();
+    member_IDs.clear();
+    for (int& rating_count : rating_counts)
+    {
+        rating_count = 0;
     }
+    rating_total = 0;
+}
+
+// Return the average rating of the rated members, or 0 if none are rated
+double Collection::get_average_rating() const
+{
+    int rated = get_rated_count();
+    return (rated == 0) ? 0. : static_cast<double>(rating_total) / rated;
+}
+
+// move a member's rating in the summary from old_rating to new_rating
+void Collection::change_rating(int old_rating, int new_rating) noexcept
+{
+    rating_counts[old_rating]--;
+    rating_counts[new_rating]++;
+    rating_total += new_rating - old_rating;
+}
+
+// add (change 1) or remove (change -1) a member's rating in the summary
+void Collection::count_rating(Record* record_ptr, int change) noexcept
+{
+    rating_counts[record_ptr->get_rating()] += change;
+    rating_total += change * record_ptr->get_rating();
+}
+
+// Write a Collection's data to a stream in save format, with endl as specified.
+void Collection::save(std::ostream& os) const
+{
+    os << name;
+    Member_writer writer(os);
+    elements.serialize(writer);
     os << "\n";
 }
 
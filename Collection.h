@@ -7,12 +7,22 @@
 #include "Utility.h"
 #include "Record.h"
 #include "Ordered_list.h"
+#include "Id_set.h"
 #include "String.h"
+#include "String_view.h"
 
 /* Collections contain a name and a container of members,
 represented as pointers to Records.
 Collection objects manage their own Record container. 
 The container of Records is not available to clients.
+Alongside the members, ordered by title for output and saving, a Collection keeps
+the set of their ID numbers, so that testing whether a Record is a member does not
+search the members.
+A Collection also keeps each member's list of the Collections containing it up to date,
+so a Collection cannot be copied, and destroying it removes it from its members' lists.
+A summary of the members' ratings - how many members have each rating - is kept up to date
+as members are added and removed and as members' ratings change, so the average rating
+and the rating counts are available without looking at the members.
 */
 
 class Collection {
@@ -30,6 +40,12 @@ public:
 	String data input is read directly into the member variable. */
     Collection(std::ifstream& is, const Ordered_list<Record*, Less_than_ptr<Record*>>& library);
 
+	// Remove this Collection from its members' lists of Collections
+	~Collection();
+
+	Collection(const Collection&) = delete;
+	Collection& operator= (const Collection&) = delete;
+
 	// Accessors
 	String get_name() const
 		{return name;}
@@ -41,11 +57,22 @@ public:
 		{ return elements.empty(); }
 	// Return true if the record is present, false if not.
 	bool is_member_present(Record* record_ptr) const;
+	// Return the set of the members' ID numbers
+	const Id_set& get_member_IDs() const
+		{ return member_IDs; }
+
+	// Return the number of members with the rating; a rating of 0 counts the unrated members
+	int get_rating_count(int rating) const
+		{ return rating_counts[rating]; }
+	// Return the number of members that have a rating
+	int get_rated_count() const
+		{ return member_IDs.size() - rating_counts[0]; }
+	// Return the average rating of the rated members, or 0 if none are rated
+	double get_average_rating() const;
 	// Remove the specified Record, throw exception if the record was not found.
 	void remove_member(Record* record_ptr);
 	// discard all members
-	void clear()
-		{ elements.clear(); }
+	void clear();
 
 	// Write a Collections's data to a stream in save format, with endl as specified.
 	void save(std::ostream& os) const;
@@ -53,12 +80,28 @@ public:
 	// This operator defines the order relation between Collections, based just on the name
 	bool operator< (const Collection& rhs) const
 		{ return name < rhs.get_name(); }
+
+	// These operators compare a Collection's name with a name given as a String_view,
+	// so that Collections can be looked up by name without constructing a probe Collection
+	bool operator< (String_view rhs) const
+		{ return String_view(name) < rhs; }
+	friend bool operator< (String_view lhs, const Collection& rhs)
+		{ return lhs < String_view(rhs.name); }
 	
 	friend std::ostream& operator<< (std::ostream& os, const Collection& collection);
 		
 private:
     Ordered_list<Record*, Less_than_ptr<Record*>> elements;
+    Id_set member_IDs;  // the IDs of the Records in elements
 	String name;
+	int rating_counts[Record::max_rating + 1] = {};     // the number of members with each rating
+	int rating_total = 0;                               // the sum of the members' ratings
+
+	// Record reports changes to its members' ratings
+	friend class Record;
+	// move a member's rating in the summary from old_rating to new_rating
+	void change_rating(int old_rating, int new_rating) noexcept;
+	void count_rating(Record* record_ptr, int change) noexcept;
 
     void print_record_title(Record* record, std::ostream& os);
 };
@@ -0,0 +1,743 @@
+#include "Id_set.h"
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+using std::uint16_t;
+using std::uint64_t;
+
+namespace {
+
+// Return the position of the first value in the array that is not less than low
+inline int lower_bound(const uint16_t* values, int n, uint16_t low)
+{
+    int first = 0;
+    while (n > 0)
+    {
+        int half = n / 2;
+        if (values[first + half] < low)
+        {
+            first += half + 1;
+            n -= half + 1;
+        }
+        else
+        {
+            n = half;
+        }
+    }
+    return first;
+}
+
+// Return the position of the first value at or after first that is not less than target,
+// by galloping: steps that double in length from first, then a binary search of the last step
+inline int gallop(const uint16_t* values, int first, int n, uint16_t target)
+{
+    int step = 1;
+    while (first + step < n && values[first + step] < target)
+    {
+        first += step;
+        step *= 2;
+    }
+    int last = (first + step + 1 < n) ? first + step + 1 : n;
+    return first + lower_bound(values + first, last - first, target);
+}
+
+// When one array has this many times the values of the other, the values of the smaller
+// are found in the larger by galloping instead of merging the two
+const int gallop_ratio = 32;
+
+/* The array kernels combine sorted arrays of values; each writes its result to out,
+unless out is nullptr, and returns the number of values in the result. */
+
+int intersect_arrays(const uint16_t* a, int na, const uint16_t* b, int nb, uint16_t* out)
+{
+    if (na > nb)
+    {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    int n = 0;
+    if (na * gallop_ratio < nb)
+    {
+        int j = 0;
+        for (int i = 0; i < na; i++)
+        {
+            j = gallop(b, j, nb, a[i]);
+            if (j == nb)
+            {
+                break;
+            }
+            if (b[j] == a[i])
+            {
+                if (out) out[n] = a[i];
+                n++;
+            }
+        }
+        return n;
+    }
+    int i = 0, j = 0;
+    while (i < na && j < nb)
+    {
+        if (a[i] < b[j])
+        {
+            i++;
+        }
+        else if (b[j] < a[i])
+        {
+            j++;
+        }
+        else
+        {
+            if (out) out[n] = a[i];
+            n++;
+            i++;
+            j++;
+        }
+    }
+    return n;
+}
+
+int unite_arrays(const uint16_t* a, int na, const uint16_t* b, int nb, uint16_t* out)
+{
+    int n = 0, i = 0, j = 0;
+    while (i < na && j < nb)
+    {
+        if (a[i] < b[j])
+        {
+            out[n++] = a[i++];
+        }
+        else if (b[j] < a[i])
+        {
+            out[n++] = b[j++];
+        }
+        else
+        {
+            out[n++] = a[i++];
+            j++;
+        }
+    }
+    while (i < na)
+    {
+        out[n++] = a[i++];
+    }
+    while (j < nb)
+    {
+        out[n++] = b[j++];
+    }
+    return n;
+}
+
+int subtract_arrays(const uint16_t* a, int na, const uint16_t* b, int nb, uint16_t* out)
+{
+    int n = 0, j = 0;
+    bool galloping = na * gallop_ratio < nb;
+    for (int i = 0; i < na; i++)
+    {
+        if (galloping)
+        {
+            j = gallop(b, j, nb, a[i]);
+        }
+        else
+        {
+            while (j < nb && b[j] < a[i])
+            {
+                j++;
+            }
+        }
+        if (j == nb || b[j] != a[i])
+        {
+            out[n++] = a[i];
+        }
+    }
+    return n;
+}
+
+// Return true if the low bits are set in the bitmap
+inline bool test_bit(const uint64_t* bits, uint16_t low)
+{
+    return (bits[low >> 6] >> (low & 63)) & 1;
+}
+
+}
+
+// Create an empty set
+Id_set::Id_set() :
+    containers(nullptr), num_containers(0), container_capacity(0), count(0)
+{
+}
+
+Id_set::Id_set(const Id_set& original) :
+    Id_set()
+{
+    if (original.num_containers == 0)
+    {
+        return;
+    }
+    containers = new Container[original.num_containers];
+    container_capacity = original.num_containers;
+    for (int i = 0; i < original.num_containers; i++)
+    {
+        const Container& from = original.containers[i];
+        Container& to = containers[i];
+        to = from;
+        to.values = nullptr;
+        to.bits = nullptr;
+        num_containers = i + 1;     // so the destructor frees this container if the copy fails
+        if (from.bits)
+        {
+            to.bits = new uint64_t[bitmap_words];
+            memcpy(to.bits, from.bits, bitmap_words * sizeof(uint64_t));
+        }
+        else
+        {
+            to.values = new uint16_t[from.capacity];
+            memcpy(to.values, from.values, from.count * sizeof(uint16_t));
+        }
+    }
+    count = original.count;
+}
+
+Id_set::Id_set(Id_set&& original) noexcept :
+    Id_set()
+{
+    swap(original);
+}
+
+Id_set& Id_set::operator= (const Id_set& rhs)
+{
+    Id_set temp(rhs);
+    swap(temp);
+    return *this;
+}
+
+Id_set& Id_set::operator= (Id_set&& rhs) noexcept
+{
+    swap(rhs);
+    return *this;
+}
+
+Id_set::~Id_set() noexcept
+{
+    clear();
+    delete[] containers;
+}
+
+// Add the ID, which must be non-negative; return false if it was already present
+bool Id_set::insert(int ID)
+{
+    assert(ID >= 0);
+    int key = ID >> 16;
+    int i = find_container(key);
+    if (i == num_containers || containers[i].key != key)
+    {
+        insert_container(i, key);
+    }
+    bool inserted;
+    try
+    {
+        inserted = insert_value(containers[i], ID & 0xFFFF);
+    }
+    catch (...)
+    {
+        // don't leave a new container empty
+        if (containers[i].count == 0)
+        {
+            erase_container(i);
+        }
+        throw;
+    }
+    if (!inserted)
+    {
+        return false;
+    }
+    count++;
+    return true;
+}
+
+// Remove the ID; return false if it was not present
+bool Id_set::erase(int ID)
+{
+    int key = ID >> 16;
+    int i = find_container(key);
+    if (ID < 0 || i == num_containers || containers[i].key != key
+        || !erase_value(containers[i], ID & 0xFFFF))
+    {
+        return false;
+    }
+    count--;
+    if (containers[i].count == 0)
+    {
+        erase_container(i);
+    }
+    return true;
+}
+
+// Return true if the ID is present
+bool Id_set::contains(int ID) const
+{
+    int key = ID >> 16;
+    int i = find_container(key);
+    return ID >= 0 && i < num_containers && containers[i].key == key
+        && contains_value(containers[i], ID & 0xFFFF);
+}
+
+// Remove all of the IDs
+void Id_set::clear() noexcept
+{
+    for (int i = 0; i < num_containers; i++)
+    {
+        free_container(containers[i]);
+    }
+    num_containers = 0;
+    count = 0;
+}
+
+void Id_set::swap(Id_set& other) noexcept
+{
+    std::swap(containers, other.containers);
+    std::swap(num_containers, other.num_containers);
+    std::swap(container_capacity, other.container_capacity);
+    std::swap(count, other.count);
+}
+
+// Store the IDs in increasing order in the array, which must have room for size() IDs
+void Id_set::get_IDs(int* IDs) const
+{
+    for (int i = 0; i < num_containers; i++)
+    {
+        const Container& container = containers[i];
+        int high = container.key << 16;
+        if (!container.bits)
+        {
+            for (int j = 0; j < container.count; j++)
+            {
+                *IDs++ = high | container.values[j];
+            }
+            continue;
+        }
+        for (int word = 0; word < bitmap_words; word++)
+        {
+            for (uint64_t w = container.bits[word]; w != 0; w &= w - 1)
+            {
+                *IDs++ = high | (word * 64 + __builtin_ctzll(w));
+            }
+        }
+    }
+}
+
+// Return the set of IDs in either a or b
+Id_set Id_set::set_union(const Id_set& a, const Id_set& b)
+{
+    return combine(a, b, union_operation);
+}
+
+// Return the set of IDs in both a and b
+Id_set Id_set::set_intersection(const Id_set& a, const Id_set& b)
+{
+    return combine(a, b, intersection_operation);
+}
+
+// Return the set of IDs in a but not in b
+Id_set Id_set::set_difference(const Id_set& a, const Id_set& b)
+{
+    return combine(a, b, difference_operation);
+}
+
+// Return the number of IDs in both a and b
+int Id_set::intersection_size(const Id_set& a, const Id_set& b)
+{
+    int n = 0;
+    int i = 0, j = 0;
+    while (i < a.num_containers && j < b.num_containers)
+    {
+        if (a.containers[i].key < b.containers[j].key)
+        {
+            i++;
+        }
+        else if (b.containers[j].key < a.containers[i].key)
+        {
+            j++;
+        }
+        else
+        {
+            n += intersection_size(a.containers[i++], b.containers[j++]);
+        }
+    }
+    return n;
+}
+
+// Combine the sets a container at a time; a key that only one set has
+// is combined with an empty container
+Id_set Id_set::combine(const Id_set& a, const Id_set& b, Operation operation)
+{
+    const Container no_container = {0, 0, nullptr, 0, nullptr};
+    Id_set result;
+    int i = 0, j = 0;
+    while (i < a.num_containers || j < b.num_containers)
+    {
+        bool in_a = i < a.num_containers && (j == b.num_containers || a.containers[i].key <= b.containers[j].key);
+        bool in_b = j < b.num_containers && (i == a.num_containers || b.containers[j].key <= a.containers[i].key);
+        const Container& a_container = in_a ? a.containers[i++] : no_container;
+        const Container& b_container = in_b ? b.containers[j++] : no_container;
+        if ((operation == intersection_operation && !(in_a && in_b))
+            || (operation == difference_operation && !in_a))
+        {
+            continue;
+        }
+        Container container = {in_a ? a_container.key : b_container.key, 0, nullptr, 0, nullptr};
+        try
+        {
+            combine_containers(a_container, b_container, operation, container);
+        }
+        catch (...)
+        {
+            free_container(container);
+            throw;
+        }
+        if (container.count > 0)
+        {
+            result.append_container(container);
+        }
+    }
+    return result;
+}
+
+// Set the result container's IDs from combining the IDs of a and b
+void Id_set::combine_containers(const Container& a, const Container& b, Operation operation,
+    Container& result)
+{
+    uint16_t buffer[2 * array_max];
+    int n = -1;     // the number of values in the buffer, if the result was built there
+    if (!a.bits && !b.bits)
+    {
+        switch (operation)
+        {
+            case union_operation:
+                n = unite_arrays(a.values, a.count, b.values, b.count, buffer);
+                break;
+            case intersection_operation:
+                n = intersect_arrays(a.values, a.count, b.values, b.count, buffer);
+                break;
+            case difference_operation:
+                n = subtract_arrays(a.values, a.count, b.values, b.count, buffer);
+                break;
+        }
+    }
+    else if (!a.bits && operation != union_operation)
+    {
+        // keep the values of a that are, or are not, in b
+        bool keep_if_in_b = operation == intersection_operation;
+        n = 0;
+        for (int i = 0; i < a.count; i++)
+        {
+            if (test_bit(b.bits, a.values[i]) == keep_if_in_b)
+            {
+                buffer[n++] = a.values[i];
+            }
+        }
+    }
+    else if (!b.bits && operation == intersection_operation)
+    {
+        n = 0;
+        for (int i = 0; i < b.count; i++)
+        {
+            if (test_bit(a.bits, b.values[i]))
+            {
+                buffer[n++] = b.values[i];
+            }
+        }
+    }
+    if (n >= 0 && n <= array_max)
+    {
+        if (n > 0)
+        {
+            result.values = new uint16_t[n];
+            memcpy(result.values, buffer, n * sizeof(uint16_t));
+            result.capacity = n;
+            result.count = n;
+        }
+        return;
+    }
+    if (n > array_max)
+    {
+        // a union of two arrays too big for an array
+        result.bits = new uint64_t[bitmap_words]();
+        for (int i = 0; i < n; i++)
+        {
+            result.bits[buffer[i] >> 6] |= uint64_t(1) << (buffer[i] & 63);
+        }
+        result.count = n;
+        return;
+    }
+    // combine the bitmaps, making one for a container that is an array
+    uint64_t a_scratch[bitmap_words];
+    uint64_t b_scratch[bitmap_words];
+    const uint64_t* a_bits = a.bits;
+    const uint64_t* b_bits = b.bits;
+    if (!a_bits)
+    {
+        memset(a_scratch, 0, sizeof(a_scratch));
+        for (int i = 0; i < a.count; i++)
+        {
+            a_scratch[a.values[i] >> 6] |= uint64_t(1) << (a.values[i] & 63);
+        }
+        a_bits = a_scratch;
+    }
+    if (!b_bits)
+    {
+        memset(b_scratch, 0, sizeof(b_scratch));
+        for (int i = 0; i < b.count; i++)
+        {
+            b_scratch[b.values[i] >> 6] |= uint64_t(1) << (b.values[i] & 63);
+        }
+        b_bits = b_scratch;
+    }
+    uint64_t* bits = new uint64_t[bitmap_words];
+    int count = 0;
+    for (int word = 0; word < bitmap_words; word++)
+    {
+        uint64_t w;
+        switch (operation)
+        {
+            case union_operation:
+                w = a_bits[word] | b_bits[word];
+                break;
+            case intersection_operation:
+                w = a_bits[word] & b_bits[word];
+                break;
+            default:
+                w = a_bits[word] & ~b_bits[word];
+                break;
+        }
+        bits[word] = w;
+        count += __builtin_popcountll(w);
+    }
+    result.bits = bits;
+    result.count = count;
+    if (count == 0)
+    {
+        delete[] bits;
+        result.bits = nullptr;
+    }
+    else if (count <= array_max)
+    {
+        to_array(result);
+    }
+}
+
+// Return the number of IDs in both containers
+int Id_set::intersection_size(const Container& a, const Container& b)
+{
+    if (!a.bits && !b.bits)
+    {
+        return intersect_arrays(a.values, a.count, b.values, b.count, nullptr);
+    }
+    if (!a.bits || !b.bits)
+    {
+        const Container& array = a.bits ? b : a;
+        const uint64_t* bits = a.bits ? a.bits : b.bits;
+        int n = 0;
+        for (int i = 0; i < array.count; i++)
+        {
+            n += test_bit(bits, array.values[i]);
+        }
+        return n;
+    }
+    int n = 0;
+    for (int word = 0; word < bitmap_words; word++)
+    {
+        n += __builtin_popcountll(a.bits[word] & b.bits[word]);
+    }
+    return n;
+}
+
+// Add the container, which has a larger key than any in the set, and take over its memory
+void Id_set::append_container(Container& container)
+{
+    try
+    {
+        insert_container(num_containers, container.key);
+    }
+    catch (...)
+    {
+        free_container(container);
+        throw;
+    }
+    containers[num_containers - 1] = container;
+    count += container.count;
+}
+
+// Return the position of the container with the key, or of the first container with a
+// larger key if there is none; the containers of a set are few, so a linear search is used
+int Id_set::find_container(int key) const
+{
+    int i = 0;
+    while (i < num_containers && containers[i].key < key)
+    {
+        i++;
+    }
+    return i;
+}
+
+// Insert an empty array container with the key at position i
+void Id_set::insert_container(int i, int key)
+{
+    if (num_containers == container_capacity)
+    {
+        int new_capacity = (container_capacity == 0) ? 1 : 2 * container_capacity;
+        Container* new_containers = new Container[new_capacity];
+        for (int j = 0; j < num_containers; j++)
+        {
+            new_containers[j] = containers[j];
+        }
+        delete[] containers;
+        containers = new_containers;
+        container_capacity = new_capacity;
+    }
+    for (int j = num_containers; j > i; j--)
+    {
+        containers[j] = containers[j - 1];
+    }
+    containers[i] = Container{key, 0, nullptr, 0, nullptr};
+    num_containers++;
+}
+
+// Remove the container at position i
+void Id_set::erase_container(int i) noexcept
+{
+    free_container(containers[i]);
+    for (int j = i + 1; j < num_containers; j++)
+    {
+        containers[j - 1] = containers[j];
+    }
+    num_containers--;
+}
+
+bool Id_set::insert_value(Container& container, uint16_t low)
+{
+    if (!container.bits && container.count == array_max && !contains_value(container, low))
+    {
+        to_bitmap(container);
+    }
+    if (container.bits)
+    {
+        uint64_t mask = uint64_t(1) << (low & 63);
+        if (container.bits[low >> 6] & mask)
+        {
+            return false;
+        }
+        container.bits[low >> 6] |= mask;
+        container.count++;
+        return true;
+    }
+    int i = lower_bound(container.values, container.count, low);
+    if (i < container.count && container.values[i] == low)
+    {
+        return false;
+    }
+    if (container.count == container.capacity)
+    {
+        int new_capacity = (container.capacity == 0) ? 4 : 2 * container.capacity;
+        if (new_capacity > array_max)
+        {
+            new_capacity = array_max;
+        }
+        uint16_t* new_values = new uint16_t[new_capacity];
+        if (container.count > 0)
+        {
+            memcpy(new_values, container.values, container.count * sizeof(uint16_t));
+        }
+        delete[] container.values;
+        container.values = new_values;
+        container.capacity = new_capacity;
+    }
+    memmove(container.values + i + 1, container.values + i, (container.count - i) * sizeof(uint16_t));
+    container.values[i] = low;
+    container.count++;
+    return true;
+}
+
+bool Id_set::erase_value(Container& container, uint16_t low)
+{
+    if (container.bits)
+    {
+        uint64_t mask = uint64_t(1) << (low & 63);
+        if (!(container.bits[low >> 6] & mask))
+        {
+            return false;
+        }
+        container.bits[low >> 6] &= ~mask;
+        container.count--;
+        if (container.count < array_min && container.count > 0)
+        {
+            // if there is no memory for the array, the container stays a bitmap
+            try
+            {
+                to_array(container);
+            }
+            catch (...)
+            {
+            }
+        }
+        return true;
+    }
+    int i = lower_bound(container.values, container.count, low);
+    if (i == container.count || container.values[i] != low)
+    {
+        return false;
+    }
+    memmove(container.values + i, container.values + i + 1, (container.count - i - 1) * sizeof(uint16_t));
+    container.count--;
+    return true;
+}
+
+bool Id_set::contains_value(const Container& container, uint16_t low)
+{
+    if (container.bits)
+    {
+        return test_bit(container.bits, low);
+    }
+    int i = lower_bound(container.values, container.count, low);
+    return i < container.count && container.values[i] == low;
+}
+
+// Change a full array container into a bitmap container
+void Id_set::to_bitmap(Container& container)
+{
+    uint64_t* bits = new uint64_t[bitmap_words]();
+    for (int i = 0; i < container.count; i++)
+    {
+        uint16_t low = container.values[i];
+        bits[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+    delete[] container.values;
+    container.values = nullptr;
+    container.capacity = 0;
+    container.bits = bits;
+}
+
+// Change a bitmap container into an array container
+void Id_set::to_array(Container& container)
+{
+    uint16_t* values = new uint16_t[array_max];
+    int n = 0;
+    for (int word = 0; word < bitmap_words; word++)
+    {
+        for (uint64_t w = container.bits[word]; w != 0; w &= w - 1)
+        {
+            values[n++] = static_cast<uint16_t>(word * 64 + __builtin_ctzll(w));
+        }
+    }
+    delete[] container.bits;
+    container.bits = nullptr;
+    container.values = values;
+    container.capacity = array_max;
+}
+
+void Id_set::free_container(Container& container) noexcept
+{
+    delete[] container.values;
+    delete[] container.bits;
+    container.values = nullptr;
+    container.bits = nullptr;
+}
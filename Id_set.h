@@ -0,0 +1,114 @@
+#ifndef ID_SET_H
+#define ID_SET_H
+
+#include <cstdint>
+
+/*
+An Id_set is a set of non-negative ID numbers stored as a compressed bitmap, in the manner
+of a "roaring" bitmap. The IDs are split by their high 16 bits into containers, kept in
+an array sorted by those bits; each container holds the low 16 bits of its IDs either
+as a sorted array of 16-bit values, while it has few IDs, or as a bitmap of 65536 bits
+once it has more IDs than the bitmap takes the space of. A container changes between
+the two forms as IDs are added and removed, and is discarded when it becomes empty.
+A bitmap container goes back to an array only when it has fallen to half that size,
+so adding and removing an ID at the boundary does not convert the container each time.
+
+Since the IDs of Records are handed out in increasing order, the IDs of a set usually
+fall in one or a few containers, so finding an ID's container takes a step or two, and
+testing an ID is then a bit test or a binary search of at most 4096 values.
+
+Id_sets can be copied, moved, and swapped.
+
+The union, intersection, and difference of two sets are computed a container at a time,
+for the containers whose keys match. Two bitmap containers are combined 64 IDs at a time
+with word operations. Two array containers are merged, or, when one is much smaller than
+the other, each value of the smaller is found in the larger by galloping search - doubling
+steps from the last value found, then a binary search. An array and a bitmap are combined
+by testing the array's values in the bitmap. The size of an intersection is counted the
+same way without building the result.
+*/
+
+class Id_set {
+public:
+    // Create an empty set
+    Id_set();
+    Id_set(const Id_set& original);
+    Id_set(Id_set&& original) noexcept;
+    Id_set& operator= (const Id_set& rhs);
+    Id_set& operator= (Id_set&& rhs) noexcept;
+    ~Id_set() noexcept;
+
+    // Add the ID, which must be non-negative; return false if it was already present
+    bool insert(int ID);
+    // Remove the ID; return false if it was not present
+    bool erase(int ID);
+    // Return true if the ID is present
+    bool contains(int ID) const;
+    // Remove all of the IDs
+    void clear() noexcept;
+
+    // Return the number of IDs in the set
+    int size() const
+        {return count;}
+    bool empty() const
+        {return count == 0;}
+
+    void swap(Id_set& other) noexcept;
+
+    // Store the IDs in increasing order in the array, which must have room for size() IDs
+    void get_IDs(int* IDs) const;
+
+    // Return the set of IDs in either a or b
+    static Id_set set_union(const Id_set& a, const Id_set& b);
+    // Return the set of IDs in both a and b
+    static Id_set set_intersection(const Id_set& a, const Id_set& b);
+    // Return the set of IDs in a but not in b
+    static Id_set set_difference(const Id_set& a, const Id_set& b);
+
+    // Return the number of IDs in both a and b
+    static int intersection_size(const Id_set& a, const Id_set& b);
+    // Return the number of IDs in either a or b
+    static int union_size(const Id_set& a, const Id_set& b)
+        {return a.size() + b.size() - intersection_size(a, b);}
+    // Return the number of IDs in a but not in b
+    static int difference_size(const Id_set& a, const Id_set& b)
+        {return a.size() - intersection_size(a, b);}
+
+private:
+    // a container holds the IDs whose high 16 bits are its key
+    struct Container {
+        int key;
+        int count;                  // the number of IDs in the container
+        std::uint16_t* values;      // the sorted low bits, or nullptr in a bitmap container
+        int capacity;               // the space for values
+        std::uint64_t* bits;        // the bitmap of low bits, or nullptr in an array container
+    };
+
+    static const int array_max = 4096;              // the most values in an array container
+    static const int array_min = array_max / 2;     // a bitmap container with fewer values becomes an array
+    static const int bitmap_words = 65536 / 64;
+
+    Container* containers;      // sorted by key
+    int num_containers;
+    int container_capacity;
+    int count;
+
+    enum Operation {union_operation, intersection_operation, difference_operation};
+
+    int find_container(int key) const;
+    static Id_set combine(const Id_set& a, const Id_set& b, Operation operation);
+    static void combine_containers(const Container& a, const Container& b, Operation operation,
+        Container& result);
+    static int intersection_size(const Container& a, const Container& b);
+    void append_container(Container& container);
+    void insert_container(int i, int key);
+    void erase_container(int i) noexcept;
+    static bool insert_value(Container& container, std::uint16_t low);
+    static bool erase_value(Container& container, std::uint16_t low);
+    static bool contains_value(const Container& container, std::uint16_t low);
+    static void to_bitmap(Container& container);
+    static void to_array(Container& container);
+    static void free_container(Container& container) noexcept;
+};
+
+#endif
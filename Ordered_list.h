@@ -80,6 +80,15 @@ is NOT deallocated. In short, the Ordered_list does not attempt to manage the us
 If any operations are attempted that are erroneous (e.g. erasing a non-existent node), the
 results are undefined. 
 
+The list adapts its representation to its size and workload. A small list, or one that is
+mostly being inserted into and erased from, is searched by walking the links. Once a list
+grows past a threshold and is mostly being searched, it is promoted: an index array of node
+pointers in list order is built alongside the links, and find and insert then locate their
+position with a binary search using the ordering function. The index is discarded again if
+the list shrinks below a lower threshold or the counts of recent reads and writes show that
+writes dominate, unless the list is so long that a linked insert would cost more than
+keeping the index up to date. Iterators always designate nodes, so they are unaffected by the representation.
+
 This module includes some function templates for applying functions to items in the container,
 using iterators to specify the range of items to apply the function to.
 
@@ -89,8 +98,17 @@ The list Node constructors and destructor increment/decrement g_Ordered_list_Nod
 
 #include "p2_globals.h"
 #include <utility>
+#include <new>
+#include <cstring>
 #include <cassert>
 
+// Hint that the memory at address p will be read soon; does nothing if unsupported.
+#if defined(__GNUC__)
+#define ORDERED_LIST_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define ORDERED_LIST_PREFETCH(p) ((void)(p))
+#endif
+
 // These Function Object Class templates make it simple to use a class's less-than operator
 // for the ordering function in declaring an Ordered_list container.
 // These declare operator() as a const member function because the function does
@@ -105,9 +123,17 @@ struct Less_than_ref {
 };
 
 // Compare two pointers (T is a pointer type) using *T's operator<
+// This is a transparent ordering function: it also compares a pointer with a key of
+// another type K, using operator< between *T and K, so a list can be searched with a key
+// (see find) as long as *T and K can be compared in both orders.
 template<typename T>
 struct Less_than_ptr {
+	typedef void is_transparent;
 	bool operator()(const T p1, const T p2) const {return *p1 < *p2;}
+	template<typename K>
+	bool operator()(const T p, const K& key) const {return *p < key;}
+	template<typename K>
+	bool operator()(const K& key, const T p) const {return key < *p;}
 };
 
 
@@ -285,6 +311,23 @@ public:
     // terminated as soon as possible by detecting when the scan goes past where
     // the matching item would be.
 	Iterator find(const T& probe_datum) const noexcept;
+
+	// This version of find is available if the ordering function is transparent, i.e. it
+    // declares the type is_transparent, and compares a key of type K with T in both orders.
+    // It finds the first item equal to the probe_key, so that no object of type T has to
+    // be constructed just to serve as a probe.
+	template<typename K, typename O = OF, typename = typename O::is_transparent>
+	Iterator find(const K& probe_key) const noexcept;
+
+	// Find each of the n probes in probes[], and store in results[i] the Iterator that
+    // find would return for probes[i]. The probes may be of type T or a key type that the
+    // ordering function compares with T. If the list is walked by its links, up to
+    // find_lanes searches are advanced together, one step each in turn, and the next node
+    // of each is prefetched, so the cache misses of the separate searches overlap
+    // instead of being paid one after the other.
+	template<typename P>
+	void find_many(const P* probes, Iterator* results, int n) const noexcept;
+	static const int find_lanes = 8;
 	
 	// Delete the specified node.
 	// Caller is responsible for any required deletion of any pointed-to data beforehand.
@@ -299,6 +342,32 @@ public:
     // Thus the no-throw guarantee can be provided.
 	void swap(Ordered_list & other) noexcept;
 
+	// Replace the contents of this list with copies of the items in [first_it, last_it),
+    // ordered by the ordering function. The nodes are sorted with a bottom-up merge sort,
+    // making O(n log n) comparisons, and then linked in one pass, instead of being inserted
+    // one at a time. Items that are equal are kept in the order they were supplied.
+	// Basic and strong exception guarantee: if copying an item or allocating fails,
+    // the new nodes are destroyed and this list is unchanged.
+	template<typename IT>
+	void sort_load(IT first_it, IT last_it);
+
+	// Write the contents of the list to a writer object: writer.write_count(n) is called
+    // with the number of items, then writer.write(item) for each item in list order.
+	template<typename W>
+	void serialize(W& writer) const;
+
+	// Add items read from a reader object to the list: reader.read_count() is called for
+    // the number of items n, then reader.read() n times, each returning an item.
+    // An item that is not less than the current last item goes at the end of the list, which
+    // takes a single call to the ordering function, so a list written by serialize is rebuilt
+    // in linear time; any other item is inserted in the usual way, so the result is the same
+    // as inserting each item in turn. If the reader or a copy throws an exception,
+    // the items already read remain in the list and the exception is propagated.
+    // If adding an item that was read fails, the item is handed back with
+    // reader.discard(item), so the reader can dispose of it, before the exception propagates.
+	template<typename R>
+	void deserialize(R& reader);
+
 private:
 	// member variable declaration for the ordering function object.
 	OF ordering_f;  // declares an object of OF type
@@ -306,8 +375,36 @@ private:
     Node *first;
     Node *last;
 
+    // The index is nullptr unless the list has been promoted; if present it holds pointers to
+    // all the nodes in list order. The counters record recent finds (reads) and inserts and
+    // erases (writes). These are mutable because find is a const member function.
+    mutable Node **index;
+    mutable int index_capacity;
+    mutable int reads;
+    mutable int writes;
+
+    // lists at least this long may be promoted; promoted lists shorter than this are demoted
+    static const int promote_length = 32;
+    static const int demote_length = 16;
+    // lists at least this long keep their index whatever the workload, because a linked
+    // insert would itself have to walk half the list on average
+    static const int large_length = 1024;
+    // the counters are examined and halved each time this many accesses have been made
+    static const int adapt_window = 64;
+
     Ordered_list& copy(const Ordered_list& original);
     void insert_node(Node* new_node);
+    void append_node(Node* new_node);
+
+    void adapt(bool is_write) const noexcept;
+    void build_index() const noexcept;
+    void drop_index() const noexcept;
+    void reserve_index() noexcept;
+    template<typename P>
+    Iterator find_probe(const P& probe) const noexcept;
+    template<typename P>
+    int lower_position(const P& probe) const;
+    int upper_position(const T& datum) const;
 };
 
 // These function templates are given two iterators, usually .begin() and .end(),
@@ -368,6 +465,10 @@ Ordered_list<T, OF>::Ordered_list()
     length = 0;
     first = nullptr;
     last = nullptr;
+    index = nullptr;
+    index_capacity = 0;
+    reads = 0;
+    writes = 0;
     g_Ordered_list_count++;
 }
 
@@ -402,6 +503,10 @@ Ordered_list<T, OF>::Ordered_list(const Ordered_list<T, OF>& original)
     length = 0;
     first = nullptr;
     last = nullptr;
+    index = nullptr;
+    index_capacity = 0;
+    reads = 0;
+    writes = 0;
     copy(original);
     g_Ordered_list_count++;
 }
@@ -412,6 +517,10 @@ Ordered_list<T, OF>::Ordered_list(Ordered_list<T, OF>&& original) noexcept
     length = 0;
     first = nullptr;
     last = nullptr;
+    index = nullptr;
+    index_capacity = 0;
+    reads = 0;
+    writes = 0;
     g_Ordered_list_count++;
     swap(original);
     g_Ordered_list_count++;
@@ -441,15 +550,39 @@ Ordered_list<T, OF>::~Ordered_list<T, OF>()
 template<typename T, typename OF>
 void Ordered_list<T, OF>::clear() noexcept
 {
-    while (length > 0)
+    drop_index();
+    Node *node = first;
+    while (node != nullptr)
     {
-        erase(begin());
+        Node *next = node->next;
+        delete node;
+        node = next;
     }
+    length = 0;
+    first = nullptr;
+    last = nullptr;
+    reads = 0;
+    writes = 0;
 }
 
 template<typename T, typename OF>
 void Ordered_list<T, OF>::insert_node(Node *new_node)
 {
+    if (index != nullptr)
+    {
+        // the new node goes after any equal nodes, just as in the linked scan below
+        int pos = upper_position(new_node->datum);
+        Node *next = (pos < length) ? index[pos] : nullptr;
+        new_node->next = next;
+        new_node->prev = (next != nullptr) ? next->prev : last;
+        if (new_node->prev != nullptr) new_node->prev->next = new_node;
+        else first = new_node;
+        if (next != nullptr) next->prev = new_node;
+        else last = new_node;
+        std::memmove(index + pos + 1, index + pos, (length - pos) * sizeof(Node*));
+        index[pos] = new_node;
+        return;
+    }
     Node *node = first;
     if (node == nullptr)
     {
@@ -486,9 +619,22 @@ void Ordered_list<T, OF>::insert_node(Node *new_node)
     last = new_node;
 }
 
+template<typename T, typename OF>
+void Ordered_list<T, OF>::append_node(Node *new_node)
+{
+    new_node->prev = last;
+    new_node->next = nullptr;
+    if (last != nullptr) last->next = new_node;
+    else first = new_node;
+    last = new_node;
+    if (index != nullptr) index[length] = new_node;
+}
+
 template<typename T, typename OF>
 void Ordered_list<T, OF>::insert(const T& new_datum)
 {
+    adapt(true);
+    reserve_index();
     insert_node(new Node(new_datum, nullptr, nullptr));
     length++;
 }
@@ -496,6 +642,8 @@ void Ordered_list<T, OF>::insert(const T& new_datum)
 template<typename T, typename OF>
 void Ordered_list<T, OF>::insert(T&& new_datum)
 {
+    adapt(true);
+    reserve_index();
     insert_node(new Node(std::move(new_datum), nullptr, nullptr));
     length++;
 }
@@ -503,12 +651,35 @@ void Ordered_list<T, OF>::insert(T&& new_datum)
 template<typename T, typename OF>
 typename Ordered_list<T, OF>::Iterator Ordered_list<T, OF>::find(const T& probe_datum) const noexcept
 {
+    return find_probe(probe_datum);
+}
+
+template<typename T, typename OF>
+template<typename K, typename O, typename>
+typename Ordered_list<T, OF>::Iterator Ordered_list<T, OF>::find(const K& probe_key) const noexcept
+{
+    return find_probe(probe_key);
+}
+
+// Find the first item equal to the probe, which is either of type T or a key type
+// that the ordering function compares with T
+template<typename T, typename OF>
+template<typename P>
+typename Ordered_list<T, OF>::Iterator Ordered_list<T, OF>::find_probe(const P& probe) const noexcept
+{
+    adapt(false);
+    if (index != nullptr)
+    {
+        int pos = lower_position(probe);
+        if (pos < length && !ordering_f(probe, index[pos]->datum)) return Iterator(index[pos]);
+        return end();
+    }
     Node *node = first;
     while (node != nullptr)
     {
-        if (!ordering_f(node->datum, probe_datum))
+        if (!ordering_f(node->datum, probe))
         {
-            if (!ordering_f(probe_datum, node->datum)) return Iterator(node);
+            if (!ordering_f(probe, node->datum)) return Iterator(node);
             break;
         }
         node = node->next;
@@ -516,9 +687,80 @@ typename Ordered_list<T, OF>::Iterator Ordered_list<T, OF>::find(const T& probe_
     return nullptr;
 }
 
+template<typename T, typename OF>
+template<typename P>
+void Ordered_list<T, OF>::find_many(const P* probes, Iterator* results, int n) const noexcept
+{
+    for (int i = 0; i < n; i++)
+    {
+        adapt(false);
+    }
+    if (index != nullptr)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            int pos = lower_position(probes[i]);
+            bool found = pos < length && !ordering_f(probes[i], index[pos]->datum);
+            results[i] = found ? Iterator(index[pos]) : end();
+        }
+        return;
+    }
+    // Each lane holds the current node of one search, and the probe it is for;
+    // a lane whose probe is -1 is idle and is given the next unstarted probe.
+    Node *cursors[find_lanes];
+    int lane_probes[find_lanes];
+    int active = 0;
+    int next_probe = 0;
+    for (int lane = 0; lane < find_lanes; lane++)
+    {
+        lane_probes[lane] = -1;
+    }
+    ORDERED_LIST_PREFETCH(first);
+    while (next_probe < n || active > 0)
+    {
+        for (int lane = 0; lane < find_lanes; lane++)
+        {
+            int probe = lane_probes[lane];
+            if (probe < 0)
+            {
+                if (next_probe == n) continue;
+                probe = lane_probes[lane] = next_probe++;
+                cursors[lane] = first;
+                active++;
+            }
+            Node *node = cursors[lane];
+            if (node != nullptr && ordering_f(node->datum, probes[probe]))
+            {
+                cursors[lane] = node->next;
+                ORDERED_LIST_PREFETCH(node->next);
+                continue;
+            }
+            bool found = node != nullptr && !ordering_f(probes[probe], node->datum);
+            results[probe] = found ? Iterator(node) : end();
+            lane_probes[lane] = -1;
+            active--;
+        }
+    }
+}
+
 template<typename T, typename OF>
 void Ordered_list<T, OF>::erase(Iterator it) noexcept
 {
+    adapt(true);
+    if (index != nullptr)
+    {
+        if (length <= demote_length)
+        {
+            drop_index();
+        }
+        else
+        {
+            // equal items may precede this node, so scan from the first equal one
+            int pos = lower_position(it.node_ptr->datum);
+            while (index[pos] != it.node_ptr) pos++;
+            std::memmove(index + pos, index + pos + 1, (length - pos - 1) * sizeof(Node*));
+        }
+    }
     length--;
     if (it.node_ptr->prev != nullptr)
     {
@@ -551,6 +793,195 @@ void Ordered_list<T, OF>::swap(Ordered_list & other) noexcept
     other.length = temp_length;
     other.first = temp_first;
     other.last = temp_last;
+    std::swap(index, other.index);
+    std::swap(index_capacity, other.index_capacity);
+    std::swap(reads, other.reads);
+    std::swap(writes, other.writes);
+}
+
+template<typename T, typename OF>
+template<typename W>
+void Ordered_list<T, OF>::serialize(W& writer) const
+{
+    writer.write_count(length);
+    for (Node *node = first; node != nullptr; node = node->next)
+    {
+        writer.write(node->datum);
+    }
+}
+
+template<typename T, typename OF>
+template<typename R>
+void Ordered_list<T, OF>::deserialize(R& reader)
+{
+    int n = reader.read_count();
+    for (int i = 0; i < n; i++)
+    {
+        T new_datum = reader.read();
+        try
+        {
+            if (last != nullptr && ordering_f(new_datum, last->datum))
+            {
+                insert(std::move(new_datum));
+                continue;
+            }
+            adapt(true);
+            reserve_index();
+            append_node(new Node(std::move(new_datum), nullptr, nullptr));
+            length++;
+        }
+        catch (...)
+        {
+            reader.discard(new_datum);
+            throw;
+        }
+    }
+}
+
+// Count the access and, once per window, promote or demote the list according to
+// its length and the recent mix of reads and writes; the counters are then halved
+// so that the decision follows changes in the workload.
+template<typename T, typename OF>
+void Ordered_list<T, OF>::adapt(bool is_write) const noexcept
+{
+    if (is_write) writes++;
+    else reads++;
+    if (reads + writes < adapt_window) return;
+    if (index == nullptr)
+    {
+        if (length >= large_length || (length >= promote_length && reads >= writes)) build_index();
+    }
+    else if (length < large_length && writes > 4 * reads)
+    {
+        drop_index();
+    }
+    reads /= 2;
+    writes /= 2;
+}
+
+// Build the index from the links. If the memory is not available, the list simply
+// stays unpromoted, so no exception is thrown.
+template<typename T, typename OF>
+void Ordered_list<T, OF>::build_index() const noexcept
+{
+    int capacity = 2 * length;
+    Node **new_index = new (std::nothrow) Node*[capacity];
+    if (new_index == nullptr) return;
+    int i = 0;
+    for (Node *node = first; node != nullptr; node = node->next)
+    {
+        new_index[i++] = node;
+    }
+    index = new_index;
+    index_capacity = capacity;
+}
+
+template<typename T, typename OF>
+void Ordered_list<T, OF>::drop_index() const noexcept
+{
+    delete[] index;
+    index = nullptr;
+    index_capacity = 0;
+}
+
+// Make room in the index for one more node, doubling its capacity if it is full;
+// if the memory is not available the list is demoted instead.
+template<typename T, typename OF>
+void Ordered_list<T, OF>::reserve_index() noexcept
+{
+    if (index == nullptr || length < index_capacity) return;
+    Node **new_index = new (std::nothrow) Node*[2 * index_capacity];
+    if (new_index == nullptr)
+    {
+        drop_index();
+        return;
+    }
+    std::memcpy(new_index, index, length * sizeof(Node*));
+    delete[] index;
+    index = new_index;
+    index_capacity *= 2;
+}
+
+// Return the position in the index of the first node that is not less than the probe
+template<typename T, typename OF>
+template<typename P>
+int Ordered_list<T, OF>::lower_position(const P& probe) const
+{
+    int low = 0;
+    int high = length;
+    while (low < high)
+    {
+        int mid = low + (high - low) / 2;
+        if (ordering_f(index[mid]->datum, probe)) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// Return the position in the index of the first node that datum is less than
+template<typename T, typename OF>
+int Ordered_list<T, OF>::upper_position(const T& datum) const
+{
+    int low = 0;
+    int high = length;
+    while (low < high)
+    {
+        int mid = low + (high - low) / 2;
+        if (ordering_f(datum, index[mid]->datum)) high = mid;
+        else low = mid + 1;
+    }
+    return low;
+}
+
+template<typename T, typename OF>
+template<typename IT>
+void Ordered_list<T, OF>::sort_load(IT first_it, IT last_it)
+{
+    Ordered_list<T, OF> temp;
+    for (; first_it != last_it; ++first_it)
+    {
+        temp.append_node(new Node(*first_it, nullptr, nullptr));
+        temp.length++;
+    }
+    if (temp.length > 1)
+    {
+        Node **nodes = new Node*[2 * temp.length];
+        Node **scratch = nodes + temp.length;
+        int i = 0;
+        for (Node *node = temp.first; node != nullptr; node = node->next)
+        {
+            nodes[i++] = node;
+        }
+        // merge runs of width 1, 2, 4, ... back and forth between nodes and scratch;
+        // on a tie the node from the left run goes first, so the sort is stable
+        for (int width = 1; width < temp.length; width *= 2)
+        {
+            for (int low = 0; low < temp.length; low += 2 * width)
+            {
+                int mid = (low + width < temp.length) ? low + width : temp.length;
+                int high = (low + 2 * width < temp.length) ? low + 2 * width : temp.length;
+                int left = low, right = mid, out = low;
+                while (left < mid && right < high)
+                {
+                    if (temp.ordering_f(nodes[right]->datum, nodes[left]->datum))
+                        scratch[out++] = nodes[right++];
+                    else
+                        scratch[out++] = nodes[left++];
+                }
+                while (left < mid) scratch[out++] = nodes[left++];
+                while (right < high) scratch[out++] = nodes[right++];
+            }
+            std::swap(nodes, scratch);
+        }
+        temp.first = nullptr;
+        temp.last = nullptr;
+        for (i = 0; i < temp.length; i++)
+        {
+            temp.append_node(nodes[i]);
+        }
+        delete[] ((nodes < scratch) ? nodes : scratch);
+    }
+    swap(temp);
 }
 
 #endif
@@ -3,30 +3,69 @@
 #include <iostream>
 #include <cctype>
 #include "Record.h"
+#include "Collection.h"
 #include "String.h"
 #include "Utility.h"
+#include "Slab_arena.h"
 
 #include <string.h>
 #include <iostream>
 using namespace std;
 
 const int rating_min = 1;
-const int rating_max = 5;
+const int rating_max = Record::max_rating;
 int Record::ID_counter = 0;
 int Record::ID_backup = 0;
 
+// The number of Records in each block of the arena
+const int records_per_block = 1024;
+
+namespace {
+
+// The arena for all Records, created when the first Record is allocated
+Slab_arena& get_record_arena()
+{
+    static_assert(alignof(Record) <= alignof(void*), "Slab_arena does not align Records");
+    static Slab_arena arena(sizeof(Record), records_per_block);
+    return arena;
+}
+
+}
+
+// Records are allocated from a Slab_arena, so Records created one after another
+// are next to each other in memory, and deleting them all releases whole blocks.
+void* Record::operator new(std::size_t size)
+{
+    if (size != sizeof(Record))
+    {
+        return ::operator new(size);
+    }
+    return get_record_arena().allocate();
+}
+
+void Record::operator delete(void* p, std::size_t size) noexcept
+{
+    if (size != sizeof(Record))
+    {
+        ::operator delete(p);
+        return;
+    }
+    get_record_arena().deallocate(p);
+}
+
 // Create a Record object, giving it a unique ID number by first incrementing
 // a static member variable then using its value as the ID number. The rating is set to 0.
 Record::Record(const String &medium_, const String &title_)
 {
     title = title_;
-    medium = medium_;
+    medium = Atom(medium_);
     ID = ++ID_counter;
     rating = 0;
+    set_sort_key();
 }
 
 // Create a Record object suitable for use as a probe containing the supplied
-// title. The ID and rating are set to 0, and the medium is an empty String.
+// title. The ID and rating are set to 0, and the medium and sort key are empty.
 Record::Record(const String &title_)
 {
     title = title_;
@@ -36,7 +75,7 @@ Record::Record(const String &title_)
 
 // Create a Record object suitable for use as a probe containing the supplied
 // ID number - the static member variable is not modified.
-// The rating is set to 0, and the medium and title are empty Strings.
+// The rating is set to 0, and the medium and title are empty.
 Record::Record(int ID_)
 {
     ID = ID_;
@@ -52,10 +91,12 @@ Record::Record(int ID_)
 // record ID if the saved record ID is larger than the static member variable value.
 Record::Record(std::ifstream &is)
 {
-    if (!(is >> ID >> medium >> rating))
+    String medium_name;
+    if (!(is >> ID >> medium_name >> rating) || rating < 0 || rating > rating_max)
     {
         throw_file_error();
     }
+    medium = Atom(medium_name);
     if (ID > ID_counter)
     {
         ID_counter = ID;
@@ -65,23 +106,130 @@ Record::Record(std::ifstream &is)
         throw_file_error();
     }
     getline(is, title);
+    title.shrink_to_fit();
+    set_sort_key();
+}
+
+// The articles that are left out of a sort key when a title starts with them
+const char* const articles[] = {"the ", "a ", "an "};
+
+// compute the sort key from the title: lower case, without a leading article
+// unless the article is the whole title
+void Record::set_sort_key()
+{
+    const char* text = title.c_str();
+    int length = title.size();
+    for (const char* article : articles)
+    {
+        int article_length = strlen(article);
+        int matched = 0;
+        while (matched < article_length && matched < length &&
+            tolower(static_cast<unsigned char>(text[matched])) == article[matched])
+        {
+            matched++;
+        }
+        if (matched == article_length && length > article_length)
+        {
+            text += article_length;
+            length -= article_length;
+            break;
+        }
+    }
+    String key;
+    key.reserve(length);
+    for (int i = 0; i < length; i++)
+    {
+        key += static_cast<char>(tolower(static_cast<unsigned char>(text[i])));
+    }
+    sort_key.swap(key);
+}
+
+// Return true if this Record's sort key comes before rhs's;
+// Records with the same sort key are ordered by title.
+bool Record::collates_before(const Record &rhs) const
+{
+    int length = sort_key.size();
+    int rhs_length = rhs.sort_key.size();
+    int result = memcmp(sort_key.c_str(), rhs.sort_key.c_str(), (length < rhs_length) ? length : rhs_length);
+    if (result != 0)
+    {
+        return result < 0;
+    }
+    if (length != rhs_length)
+    {
+        return length < rhs_length;
+    }
+    return title < rhs.title;
 }
 
-// if the rating is not between 1 and 5 inclusive, an exception is thrown
+// if the rating is not between 1 and 5 inclusive, an exception is thrown;
+// the rating summaries of the Collections containing the Record are updated
 void Record::set_rating(int rating_)
 {
     if (rating_ < rating_min || rating_ > rating_max)
     {
         throw Error("Rating is out of range!");
     }
+    for (int i = 0; i < collection_count; i++)
+    {
+        collections[i]->change_rating(rating, rating_);
+    }
     rating = rating_;
 }
 
+// add the Collection to the list, which must not already contain it
+void Record::add_collection(Collection* collection)
+{
+    if (collection_count == collection_capacity)
+    {
+        int new_capacity = (collection_capacity == 0) ? 2 : 2 * collection_capacity;
+        Collection** new_collections = new Collection*[new_capacity];
+        for (int i = 0; i < collection_count; i++)
+        {
+            new_collections[i] = collections[i];
+        }
+        delete[] collections;
+        collections = new_collections;
+        collection_capacity = new_capacity;
+    }
+    int i = collection_count;
+    while (i > 0 && *collection < *collections[i - 1])
+    {
+        collections[i] = collections[i - 1];
+        i--;
+    }
+    collections[i] = collection;
+    collection_count++;
+}
+
+// remove the Collection from the list, which must contain it
+void Record::remove_collection(Collection* collection) noexcept
+{
+    int i = 0;
+    while (collections[i] != collection)
+    {
+        i++;
+    }
+    for (; i + 1 < collection_count; i++)
+    {
+        collections[i] = collections[i + 1];
+    }
+    collection_count--;
+}
+
 // Write a Record's data to a stream in save format with final endl.
 // The record number is saved.
 void Record::save(std::ostream &os) const
 {
-    os << ID << " " << medium << " " << rating << " " << title << "\n";
+    char number[String::max_int_chars];
+    os.write(number, String::format_int(number, ID));
+    os.put(' ');
+    os.write(medium.c_str(), medium.size());
+    os.put(' ');
+    os.write(number, String::format_int(number, rating));
+    os.put(' ');
+    os.write(title.c_str(), title.size());
+    os.put('\n');
 }
 
 // Print a Record's data to the stream without a final endl.
@@ -89,9 +237,20 @@ void Record::save(std::ostream &os) const
 // If the rating is zero, a 'u' is printed instead of the rating.
 std::ostream& operator<< (std::ostream& os, const Record& record)
 {
-    os << record.ID << ": " << record.medium << " ";
-    if (record.rating == 0) os << 'u';
-    else os << record.rating;
-    os << " " << record.title;
+    char number[String::max_int_chars];
+    os.write(number, String::format_int(number, record.ID));
+    os.write(": ", 2);
+    os.write(record.medium.c_str(), record.medium.size());
+    os.put(' ');
+    if (record.rating == 0)
+    {
+        os.put('u');
+    }
+    else
+    {
+        os.write(number, String::format_int(number, record.rating));
+    }
+    os.put(' ');
+    os.write(record.title.c_str(), record.title.size());
     return os;
 }
\ No newline at end of file
@@ -3,13 +3,30 @@
 
 #include "p2_globals.h"
 #include "String.h"
+#include "Atom.h"
+#include "String_view.h"
+#include <cstddef>
 #include <fstream>
 #include <ostream>
 
+class Collection;
+
 /*
-A Record contains a unique ID number, a rating, and a title and medium name as Strings.
+A Record contains a unique ID number, a rating, a title as a String, and a medium name
+as an Atom, since the same few medium names are shared by many Records.
 When created, a Record is assigned a unique ID number. The first Record created
 has ID number == 1.
+
+Besides the title itself, a Record holds a sort key for the title, computed once when the
+title is set: the title in lower case, without a leading "The", "A", or "An".
+Records are ordered by title, but record_collation_comp orders them by their sort keys,
+so that "The Money Pit" comes under M, comparing the keys with a single memcmp.
+The key is held in a String, so a short key takes no separate allocation; probe Records
+made to look up a title have no key.
+
+A Record also keeps a list of the Collections it is a member of, in order of name,
+which is maintained by Collection as members are added and removed; so whether a Record
+is in any Collection, and which ones, can be found without searching the catalog.
 */
 
 class Record {
@@ -20,12 +37,12 @@ public:
     Record(const String &medium_, const String &title_);
 
     // Create a Record object suitable for use as a probe containing the supplied
-    // title. The ID and rating are set to 0, and the medium is an empty String.
+    // title. The ID and rating are set to 0, and the medium and sort key are empty.
     Record(const String &title_);
 
     // Create a Record object suitable for use as a probe containing the supplied
     // ID number - the static member variable is not modified.
-    // The rating is set to 0, and the medium and title are empty Strings.
+    // The rating is set to 0, and the medium and title are empty.
     Record(int ID_);
 
     // Construct a Record object from a file stream in save format.
@@ -43,11 +60,32 @@ public:
     Record &operator=(const Record &) = delete; // disallow copy assignment
     Record &operator=(Record &&) = delete; // disallow move assignment
 
+    // Deallocate the list of Collections
+    ~Record() { delete[] collections; }
+
+    // Records are allocated from a Slab_arena, so Records created one after another
+    // are next to each other in memory, and deleting them all releases whole blocks.
+    static void* operator new(std::size_t size);
+    static void operator delete(void* p, std::size_t size) noexcept;
+
+    // The highest rating; a rating of 0 means the Record is unrated
+    static const int max_rating = 5;
+
     // Accessors
     int get_ID() const { return ID; }
 
+    int get_rating() const { return rating; }
+
     String get_title() const { return title; }
 
+    const Atom& get_medium() const { return medium; }
+
+    // Return the number of Collections this Record is a member of
+    int get_collection_count() const { return collection_count; }
+
+    // Return the i'th Collection this Record is a member of, in order of name
+    Collection* get_collection(int i) const { return collections[i]; }
+
     // reset the ID counter
     static void reset_ID_counter() { ID_counter = 0; }
 
@@ -57,7 +95,8 @@ public:
     // restore the ID counter from the value in the other static member variable
     static void restore_ID_counter() { ID_counter = ID_backup; }
 
-    // if the rating is not between 1 and 5 inclusive, an exception is thrown
+    // if the rating is not between 1 and 5 inclusive, an exception is thrown;
+    // the rating summaries of the Collections containing the Record are updated
     void set_rating(int rating_);
 
     // Write a Record's data to a stream in save format with final endl.
@@ -67,15 +106,43 @@ public:
     // This operator defines the order relation between Records, based just on the last title
     bool operator<(const Record &rhs) const { return title < rhs.title; }
 
+    // These operators compare a Record's title with a title given as a String_view,
+    // so that Records can be looked up by title without constructing a probe Record
+    bool operator<(String_view rhs) const { return String_view(title) < rhs; }
+    friend bool operator<(String_view lhs, const Record &rhs) { return lhs < String_view(rhs.title); }
+
+    // Return true if this Record's sort key comes before rhs's;
+    // Records with the same sort key are ordered by title.
+    bool collates_before(const Record &rhs) const;
+
     friend std::ostream& operator<< (std::ostream& os, const Record& record);
 
 private:
     static int ID_counter; // must be initialized to zero.
     static int ID_backup;
     String title;
-    String medium;
+    Atom medium;
     int ID;
     int rating;
+    String sort_key;    // empty in a probe Record
+    Collection** collections = nullptr;     // the Collections containing this Record, by name
+    int collection_count = 0;
+    int collection_capacity = 0;
+
+    // compute the sort key from the title
+    void set_sort_key();
+
+    // Collection keeps the list of Collections up to date
+    friend class Collection;
+    // add the Collection to the list, which must not already contain it
+    void add_collection(Collection* collection);
+    // remove the Collection from the list, which must contain it
+    void remove_collection(Collection* collection) noexcept;
+};
+
+// Compare two Record pointers by the sort keys of their titles
+struct record_collation_comp {
+    bool operator() (const Record *lhs, const Record *rhs) const { return lhs->collates_before(*rhs); }
 };
 
 
@@ -0,0 +1,142 @@
+#include "Record_table.h"
+#include "Record.h"
+#include <cassert>
+#include <utility>
+
+// Create an empty table
+Record_table::Record_table() :
+    chunks(nullptr), chunk_capacity(0), count(0)
+{
+}
+
+// Deallocate the table's memory, but not the Records
+Record_table::~Record_table() noexcept
+{
+    clear();
+}
+
+// Take the original's contents, leaving the original empty
+Record_table::Record_table(Record_table&& original) noexcept :
+    chunks(original.chunks), chunk_capacity(original.chunk_capacity), count(original.count)
+{
+    original.chunks = nullptr;
+    original.chunk_capacity = 0;
+    original.count = 0;
+}
+
+// Exchange contents with the rhs, which will release the old contents
+Record_table& Record_table::operator= (Record_table&& rhs) noexcept
+{
+    swap(rhs);
+    return *this;
+}
+
+// Add the Record at the slot for its ID, which must be between 1 and max_ID and not in the table
+void Record_table::insert(Record* record)
+{
+    int ID = record->get_ID();
+    assert(ID > 0 && ID <= max_ID && find(ID) == nullptr);
+    int chunk = ID >> chunk_bits;
+    if (chunk >= chunk_capacity)
+    {
+        int new_capacity = (chunk_capacity == 0) ? 1 : 2 * chunk_capacity;
+        while (new_capacity <= chunk)
+        {
+            new_capacity *= 2;
+        }
+        Record*** new_chunks = new Record**[new_capacity];
+        for (int i = 0; i < new_capacity; i++)
+        {
+            new_chunks[i] = (i < chunk_capacity) ? chunks[i] : nullptr;
+        }
+        delete[] chunks;
+        chunks = new_chunks;
+        chunk_capacity = new_capacity;
+    }
+    if (!chunks[chunk])
+    {
+        chunks[chunk] = new Record*[chunk_size]();
+    }
+    chunks[chunk][ID & (chunk_size - 1)] = record;
+    count++;
+}
+
+// Return the Record with the ID, or nullptr if there is none
+Record* Record_table::find(int ID) const
+{
+    int chunk = ID >> chunk_bits;
+    if (ID < 0 || chunk >= chunk_capacity || !chunks[chunk])
+    {
+        return nullptr;
+    }
+    return chunks[chunk][ID & (chunk_size - 1)];
+}
+
+// Remove the Record with the ID, which must be in the table
+void Record_table::erase(int ID)
+{
+    assert(find(ID) != nullptr);
+    chunks[ID >> chunk_bits][ID & (chunk_size - 1)] = nullptr;
+    count--;
+}
+
+// Remove all of the Records and deallocate the chunks
+void Record_table::clear() noexcept
+{
+    for (int i = 0; i < chunk_capacity; i++)
+    {
+        delete[] chunks[i];
+    }
+    delete[] chunks;
+    chunks = nullptr;
+    chunk_capacity = 0;
+    count = 0;
+}
+
+void Record_table::swap(Record_table& other) noexcept
+{
+    std::swap(chunks, other.chunks);
+    std::swap(chunk_capacity, other.chunk_capacity);
+    std::swap(count, other.count);
+}
+
+// Return an Iterator to the Record with the smallest ID
+Record_table::Iterator Record_table::begin() const
+{
+    return Iterator(this, next_ID(0));
+}
+
+// return the first ID at or after ID that has a Record, or end_ID() if there is none;
+// chunks that are not allocated are skipped as a whole
+int Record_table::next_ID(int ID) const
+{
+    while (ID < end_ID())
+    {
+        Record** chunk = chunks[ID >> chunk_bits];
+        if (!chunk)
+        {
+            ID = ((ID >> chunk_bits) + 1) << chunk_bits;
+            continue;
+        }
+        if (chunk[ID & (chunk_size - 1)])
+        {
+            return ID;
+        }
+        ID++;
+    }
+    return end_ID();
+}
+
+// advance to the next Record, skipping tombstones
+Record_table::Iterator& Record_table::Iterator::operator++ ()
+{
+    ID = table->next_ID(ID + 1);
+    return *this;
+}
+
+Record_table::Iterator Record_table::Iterator::operator++ (int)
+{
+    Iterator old(*this);
+    ++*this;
+    return old;
+}
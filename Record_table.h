@@ -0,0 +1,105 @@
+#ifndef RECORD_TABLE_H
+#define RECORD_TABLE_H
+
+class Record;
+
+/*
+A Record_table holds pointers to Records indexed directly by their ID numbers, so a Record
+is found, added, or removed in constant time. Record IDs are handed out in increasing order
+starting at 1, so the IDs in use are dense and a table indexed by ID wastes little space.
+
+The slots for the IDs are kept in fixed-size chunks, allocated as IDs in their range are
+added, with a directory of pointers to the chunks that doubles in size as needed; so the
+slots never move once allocated, and growing the table copies only the directory.
+The slot of an ID that is not in the table, such as the ID of a deleted Record,
+holds nullptr (a "tombstone"); iterating over the table visits the Records in order of
+increasing ID, skipping the tombstones.
+
+IDs may be at most max_ID, which keeps the count of slots in the table, and so the
+past-the-end ID used by the Iterators, within an int.
+
+The table does not own the Records; clear() and the destructor release only the table's
+own memory. A Record_table can be moved but not copied.
+*/
+
+class Record_table {
+public:
+    // Create an empty table
+    Record_table();
+    // Deallocate the table's memory, but not the Records
+    ~Record_table() noexcept;
+
+    // Take the original's contents, leaving the original empty
+    Record_table(Record_table&& original) noexcept;
+    // Exchange contents with the rhs, which will release the old contents
+    Record_table& operator= (Record_table&& rhs) noexcept;
+
+    Record_table(const Record_table&) = delete;
+    Record_table& operator= (const Record_table&) = delete;
+
+    // The largest ID that a table can hold
+    static const int max_ID = (1 << 30) - 1;
+
+    // Add the Record at the slot for its ID, which must be between 1 and max_ID and not in the table
+    void insert(Record* record);
+    // Return the Record with the ID, or nullptr if there is none
+    Record* find(int ID) const;
+    // Remove the Record with the ID, which must be in the table
+    void erase(int ID);
+    // Remove all of the Records and deallocate the chunks
+    void clear() noexcept;
+
+    // Return the number of Records in the table
+    int size() const
+        {return count;}
+    bool empty() const
+        {return count == 0;}
+
+    void swap(Record_table& other) noexcept;
+
+    // An Iterator visits the Records in order of increasing ID
+    class Iterator {
+    public:
+        Iterator() :
+            table(nullptr), ID(0)
+            {}
+        Record* operator* () const
+            {return table->find(ID);}
+        // advance to the next Record, skipping tombstones
+        Iterator& operator++ ();
+        Iterator operator++ (int);
+        bool operator== (Iterator rhs) const
+            {return ID == rhs.ID;}
+        bool operator!= (Iterator rhs) const
+            {return ID != rhs.ID;}
+    private:
+        friend class Record_table;
+        Iterator(const Record_table* table_, int ID_) :
+            table(table_), ID(ID_)
+            {}
+        const Record_table* table;
+        int ID;     // the ID of the Record, or the end ID
+    };
+
+    // Return an Iterator to the Record with the smallest ID
+    Iterator begin() const;
+    // Return an Iterator past the Record with the largest ID
+    Iterator end() const
+        {return Iterator(this, end_ID());}
+
+private:
+    static const int chunk_bits = 10;
+    static const int chunk_size = 1 << chunk_bits;     // slots in each chunk
+
+    Record*** chunks;   // the directory; a pointer is nullptr if the chunk is not allocated
+    int chunk_capacity; // the number of pointers in the directory
+    int count;          // the number of Records in the table
+
+    // return a past-the-end ID for iteration
+    int end_ID() const
+        {return chunk_capacity * chunk_size;}
+    // return the first ID at or after ID that has a Record, or end_ID() if there is none
+    int next_ID(int ID) const;
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "Slab_arena.h"
+#include <cassert>
+#include <new>
+
+// Create an arena for objects of object_size bytes, with slots_per_block slots in each block
+Slab_arena::Slab_arena(std::size_t object_size, int slots_per_block_) :
+    slots_per_block(slots_per_block_), blocks(nullptr), room_list(nullptr), spare(nullptr),
+    live_count(0), block_count(0)
+{
+    assert(slots_per_block > 0);
+    if (object_size < sizeof(Slot*))
+    {
+        object_size = sizeof(Slot*);
+    }
+    slot_size = sizeof(Block*) + object_size;
+    slot_size = (slot_size + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+}
+
+// Release all of the blocks
+Slab_arena::~Slab_arena() noexcept
+{
+    while (blocks)
+    {
+        Block* block = blocks;
+        blocks = block->next;
+        ::operator delete(block);
+    }
+    ::operator delete(spare);
+}
+
+// Return memory for one object, or throw std::bad_alloc
+void* Slab_arena::allocate()
+{
+    Block* block = room_list;
+    if (!block)
+    {
+        block = get_block();
+        add_to_room_list(block);
+    }
+    Slot* slot;
+    if (block->free_slots)
+    {
+        slot = block->free_slots;
+        block->free_slots = slot->next_free;
+    }
+    else
+    {
+        slot = get_slot(block, block->bumped++);
+        slot->block = block;
+    }
+    block->used++;
+    live_count++;
+    if (!block->free_slots && block->bumped == slots_per_block)
+    {
+        remove_from_room_list(block);
+    }
+    return &slot->next_free;
+}
+
+// Release memory for an object, which must have come from allocate() on this arena
+void Slab_arena::deallocate(void* p) noexcept
+{
+    if (!p)
+    {
+        return;
+    }
+    Slot* slot = reinterpret_cast<Slot*>(static_cast<char*>(p) - sizeof(Block*));
+    Block* block = slot->block;
+    slot->next_free = block->free_slots;
+    block->free_slots = slot;
+    block->used--;
+    live_count--;
+    if (block->used == 0)
+    {
+        release_block(block);
+    }
+    else if (!block->has_room)
+    {
+        add_to_room_list(block);
+    }
+}
+
+// Return slot i of the block
+Slab_arena::Slot* Slab_arena::get_slot(Block* block, int i) const
+{
+    return reinterpret_cast<Slot*>(reinterpret_cast<char*>(block + 1) + i * slot_size);
+}
+
+// Return an empty block, the spare if there is one, on the list of all blocks
+Slab_arena::Block* Slab_arena::get_block()
+{
+    Block* block = spare;
+    if (block)
+    {
+        spare = nullptr;
+    }
+    else
+    {
+        block = static_cast<Block*>(::operator new(sizeof(Block) + slots_per_block * slot_size));
+        block_count++;
+    }
+    block->free_slots = nullptr;
+    block->used = 0;
+    block->bumped = 0;
+    block->has_room = false;
+    block->prev = nullptr;
+    block->next = blocks;
+    if (blocks)
+    {
+        blocks->prev = block;
+    }
+    blocks = block;
+    return block;
+}
+
+// Take an empty block off the lists, and keep it as the spare or return it to the heap
+void Slab_arena::release_block(Block* block) noexcept
+{
+    if (block->has_room)
+    {
+        remove_from_room_list(block);
+    }
+    if (block->prev)
+    {
+        block->prev->next = block->next;
+    }
+    else
+    {
+        blocks = block->next;
+    }
+    if (block->next)
+    {
+        block->next->prev = block->prev;
+    }
+    if (!spare)
+    {
+        spare = block;
+        return;
+    }
+    ::operator delete(block);
+    block_count--;
+}
+
+void Slab_arena::add_to_room_list(Block* block) noexcept
+{
+    block->room_prev = nullptr;
+    block->room_next = room_list;
+    if (room_list)
+    {
+        room_list->room_prev = block;
+    }
+    room_list = block;
+    block->has_room = true;
+}
+
+void Slab_arena::remove_from_room_list(Block* block) noexcept
+{
+    if (block->room_prev)
+    {
+        block->room_prev->room_next = block->room_next;
+    }
+    else
+    {
+        room_list = block->room_next;
+    }
+    if (block->room_next)
+    {
+        block->room_next->room_prev = block->room_prev;
+    }
+    block->has_room = false;
+}
@@ -0,0 +1,81 @@
+#ifndef SLAB_ARENA_H
+#define SLAB_ARENA_H
+
+#include <cstddef>
+
+/*
+A Slab_arena supplies memory for objects of one fixed size, carved out of large blocks
+that each hold many slots. New slots are handed out from the newest block in address
+order, so objects created one after another - such as Records, which get increasing
+ID numbers - lie next to each other in memory. A released slot goes onto a free list
+kept by its block, and is reused before any untouched slot.
+
+Each block counts the slots in use; when the count drops to zero the whole block is
+returned to the heap in a single deallocation, except that one empty block is kept
+as a spare so that creating and deleting a single object does not allocate every time.
+Deleting all of the objects in an arena therefore releases its memory a block at a time.
+Each slot carries a pointer to its block, so a slot's block is found in constant time.
+Objects are aligned as a pointer is, which suffices for classes made of pointers and ints.
+
+A Slab_arena can be neither copied nor moved. The destructor releases all of the blocks;
+the objects must have been destroyed by then.
+*/
+
+class Slab_arena {
+public:
+    // Create an arena for objects of object_size bytes, with slots_per_block slots in each block
+    Slab_arena(std::size_t object_size, int slots_per_block);
+    // Release all of the blocks
+    ~Slab_arena() noexcept;
+
+    Slab_arena(const Slab_arena&) = delete;
+    Slab_arena& operator= (const Slab_arena&) = delete;
+
+    // Return memory for one object, or throw std::bad_alloc
+    void* allocate();
+    // Release memory for an object, which must have come from allocate() on this arena
+    void deallocate(void* p) noexcept;
+
+    // Return the number of slots in use
+    int get_live_count() const
+        {return live_count;}
+    // Return the number of blocks, including the spare
+    int get_block_count() const
+        {return block_count;}
+
+private:
+    struct Block;
+    // A slot starts with a pointer to its block; the object follows it,
+    // and while the slot is free, the object's place holds the free-list link
+    struct Slot {
+        Block* block;
+        Slot* next_free;
+    };
+    // The slots follow the Block header in the same allocation
+    struct Block {
+        Block* prev;            // the list of all blocks
+        Block* next;
+        Block* room_prev;       // the list of blocks that have room
+        Block* room_next;
+        Slot* free_slots;       // released slots, reused first
+        int used;               // slots in use
+        int bumped;             // slots handed out at least once, from the start of the block
+        bool has_room;          // true if the block is on the list of blocks that have room
+    };
+
+    std::size_t slot_size;      // the block pointer plus the object, rounded for alignment
+    int slots_per_block;
+    Block* blocks;              // all blocks except the spare
+    Block* room_list;           // blocks with a free or untouched slot, most recently added first
+    Block* spare;               // an empty block kept for reuse, or nullptr
+    int live_count;
+    int block_count;
+
+    Slot* get_slot(Block* block, int i) const;
+    Block* get_block();
+    void release_block(Block* block) noexcept;
+    void add_to_room_list(Block* block) noexcept;
+    void remove_from_room_list(Block* block) noexcept;
+};
+
+#endif
@@ -3,137 +3,383 @@
 #include <string.h>
 #include "String.h"
 #include <assert.h>
-#include <cctype>
 #include "Utility.h"
+#include "String_pool.h"
+#include "String_simd.h"
+#include <atomic>
+#include <chrono>
+#include <utility>
 
 using namespace std;
 
-char String::a_null_byte = '\0';	// to hold a null byte for empty string representation
+// The allocation policy for C-string memory; see String_pool.h
+#ifdef STRING_HEAP_ALLOCATION
+typedef String_heap_policy String_allocation_policy;
+#else
+typedef String_pool_policy String_allocation_policy;
+#endif
+
+/* The monitoring can be compiled out. Defining STRING_NO_MESSAGES removes the
+constructor, destructor, and assignment messages, so set_messages_wanted has no effect.
+Defining STRING_NO_COUNTERS removes the counting of Strings and their memory,
+so the monitoring functions that report the counts return zero.
+These are compile-time constants, so the code for a monitoring feature that is
+removed is not in the constructors, destructor, and other hot paths at all. */
+#ifdef STRING_NO_MESSAGES
+constexpr bool messages_compiled = false;
+#else
+constexpr bool messages_compiled = true;
+#endif
+#ifdef STRING_NO_COUNTERS
+constexpr bool counters_compiled = false;
+#else
+constexpr bool counters_compiled = true;
+#endif
 
 /* Variables for monitoring functions - not part of a normal implementation. */
 /* But used here for demonstration and testing purposes. */
 int String::number = 0;				// counts number of String objects in existence
 int String::total_allocation = 0;	// counts total amount of memory allocated
+int String::total_used = 0;         // counts allocated bytes holding characters or the null byte
+int String::peak_allocation = 0;    // largest value of total_allocation so far
+long String::allocation_count = 0;  // counts pieces of memory allocated so far
+long String::deallocation_count = 0;    // counts pieces of memory deallocated so far
+int String::size_histogram[String::num_size_classes] = {};  // counts pieces of memory in existence by size class
+// when the program started, for allocation rates
+const std::chrono::steady_clock::time_point statistics_start = std::chrono::steady_clock::now();
 bool String::messages_wanted = false;	// whether to output constructor/destructor/operator= messages, initially false
+String::Growth_policy String::growth_policy = String::double_growth;
+
+// The header at the start of allocated memory counts the Strings that share it, and records
+// whether it may be shared by new copies.
+struct String::Header {
+    std::atomic<int> references;
+    bool shareable;
+};
+const int String::header_size = (sizeof(String::Header) + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+
+String::Header* String::header() const
+{
+    return reinterpret_cast<Header*>(data - header_size);
+}
+
+// sets an empty inline string without deallocating anything
+void String::make_empty() noexcept
+{
+    data = inline_buffer;
+    inline_buffer[0] = '\0';
+    length = 0;
+    allocation = 0;
+    cache_flags = 0;
+}
+
+// sets an empty String to the len characters at src with minimum allocation -
+// the inline buffer if they fit, otherwise an allocation of len + 1
+void String::assign_minimum(const char* src, int len)
+{
+    assert(is_inline() && length == 0);
+    if (len >= inline_capacity)
+    {
+        data = allocate(len + 1);
+        allocation = len + 1;
+    }
+    memcpy(data, src, len);
+    data[len] = '\0';
+    set_length(len);
+}
 
-// deallocates data
+// lets go of data, deallocating it if no other String shares it
 void String::deconstruct()
 {
-    if (data != nullptr && data != &a_null_byte)
+    if (!is_inline())
     {
         assert(allocation != 0);
-        total_allocation -= allocation;
-        delete[] data;
+        Header* h = header();
+        if (h->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            if (counters_compiled)
+            {
+                total_allocation -= allocation;
+                total_used -= length + 1;
+                deallocation_count++;
+                size_histogram[get_size_class(allocation)]--;
+            }
+            h->~Header();
+            String_allocation_policy::deallocate(reinterpret_cast<char*>(h), header_size + allocation);
+        }
     }
     else
     {
-        assert(allocation == 0 && length == 0);
+        assert(allocation == 0);
     }
-    allocation = 0;
-    length = 0;
-    data = &a_null_byte;
+    make_empty();
 }
 
-// allocates a new char * and keeps track of total_allocation
+// allocates a new char * with an unshared header and keeps track of total_allocation
+// and the other statistics; the characters are not initialized, so the caller must
+// supply the null byte and count it and the characters with set_length
 char* String::allocate(int n)
 {
-    total_allocation += n;
-    char* new_data = new char[n];
-    memset(new_data, '\0', n);
-    return new_data;
+#ifndef STRING_HEAP_ALLOCATION
+    static_assert(header_size <= String_pool_policy::header_room,
+        "the String header does not fit in the room the pool leaves for it");
+#endif
+    char* memory = String_allocation_policy::allocate(header_size + n);
+    Header* h = new (memory) Header;
+    h->references.store(1, std::memory_order_relaxed);
+    h->shareable = true;
+    if (counters_compiled)
+    {
+        total_allocation += n;
+        total_used += 1;
+        if (total_allocation > peak_allocation)
+        {
+            peak_allocation = total_allocation;
+        }
+        allocation_count++;
+        size_histogram[get_size_class(n)]++;
+    }
+    return memory + header_size;
 }
 
-// resizes the string to handle if the length was increased by n characters
+// sets the length, keeping track of the allocated bytes in use
+void String::set_length(int n)
+{
+    if (counters_compiled && !is_inline())
+    {
+        total_used += n - length;
+    }
+    length = n;
+}
+
+// Return the size class of an allocation of n bytes
+int String::get_size_class(int n)
+{
+    int k = 0;
+    for (int size = min_class_size; k < num_size_classes - 1 && size < n; size *= 2)
+    {
+        k++;
+    }
+    return k;
+}
+
+// Return the number of seconds since the program started
+double String::get_statistics_seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - statistics_start).count();
+}
+
+// resizes the string to handle if the length was increased by n characters, and unshares it
 void String::resize(int n)
 {
-    assert(n > 0);
-    if (allocation < length + n + 1)
+    assert(n >= 0);
+    if (get_capacity() >= length + n + 1)
     {
-        int new_alloc = 2 * (length + n + 1);
-        int old_length = length;
-        char* new_data = allocate(new_alloc);
-        if (allocation > 0)
+        make_unique();
+    }
+    else
+    {
+        reallocate(growth_policy(length + n + 1));
+    }
+}
+
+// moves the contents into a new private allocation of new_alloc bytes
+void String::reallocate(int new_alloc)
+{
+    int old_length = length;
+    char* new_data = allocate(new_alloc);
+    memcpy(new_data, data, length + 1);
+    deconstruct();
+    data = new_data;
+    allocation = new_alloc;
+    set_length(old_length);
+}
+
+// computes the first 8 characters as a big-endian integer, padded with zero bytes
+std::uint64_t String::compute_prefix() const
+{
+    std::uint64_t value = 0;
+    int n = (length < 8) ? length : 8;
+    for (int i = 0; i < n; i++)
+    {
+        value = (value << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return (n == 0) ? 0 : value << (8 * (8 - n));
+}
+
+// Return the first 8 characters as a big-endian integer, padded with zero bytes;
+// integer order of these values agrees with the order of the Strings
+std::uint64_t String::get_prefix() const
+{
+    if (cache_flags & prefix_valid)
+    {
+        return prefix;
+    }
+    std::uint64_t value = compute_prefix();
+    if (!(cache_flags & uncacheable))
+    {
+        prefix = value;
+        cache_flags |= prefix_valid;
+    }
+    return value;
+}
+
+// Return a hash code for the contents (FNV-1a)
+unsigned int String::get_hash() const
+{
+    if (cache_flags & hash_valid)
+    {
+        return hash_code;
+    }
+    unsigned int value = 2166136261u;
+    for (int i = 0; i < length; i++)
+    {
+        value = (value ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    }
+    if (!(cache_flags & uncacheable))
+    {
+        hash_code = value;
+        cache_flags |= hash_valid;
+    }
+    return value;
+}
+
+// Return a value less than, equal to, or greater than zero, as this String
+// comes before, is equal to, or comes after rhs in the order used by operator<
+int String::compare(const String& rhs) const
+{
+    std::uint64_t lhs_prefix = get_prefix();
+    std::uint64_t rhs_prefix = rhs.get_prefix();
+    if (lhs_prefix != rhs_prefix)
+    {
+        return (lhs_prefix < rhs_prefix) ? -1 : 1;
+    }
+    // the prefixes hold all of a String of 8 or fewer characters, and no String
+    // contains a null byte, so if either is that short, they differ only in length
+    int common = (length < rhs.length) ? length : rhs.length;
+    if (common > 8)
+    {
+        int i = 8 + String_simd::find_mismatch(data + 8, rhs.data + 8, common - 8);
+        if (i < common)
         {
-            strcpy(new_data, data);
+            return static_cast<unsigned char>(data[i]) - static_cast<unsigned char>(rhs.data[i]);
         }
-        deconstruct();
-        data = new_data;
-        allocation = new_alloc;
-        length = old_length;
     }
+    return length - rhs.length;
+}
+
+// gives this String its own copy of shared memory, with the same allocation
+void String::make_unique()
+{
+    if (is_inline() || header()->references.load(std::memory_order_acquire) == 1)
+    {
+        return;
+    }
+    char* new_data = allocate(allocation);
+    memcpy(new_data, data, length + 1);
+    int old_length = length;
+    int old_alloc = allocation;
+    deconstruct();
+    data = new_data;
+    allocation = old_alloc;
+    set_length(old_length);
 }
 
 // Default initialization is to contain an empty string with no allocation.
 // If a non-empty C-string is supplied, this String gets minimum allocation.
 String::String(const char* cstr_)
 {
-    number++;
-    if (messages_wanted)
+    if (counters_compiled)
     {
-        cout << "Ctor: \"" << cstr_ << "\"\n";
+        number++;
     }
-    data = &a_null_byte;
-    allocation = 0;
-    length = 0;
-    int cstrlength = strlen(cstr_);
-    if (cstrlength > 0)
+    if (messages_compiled && messages_wanted)
     {
-        allocation = cstrlength + 1;
-        data = allocate(allocation);
-        strcpy(data, cstr_);
-        length = cstrlength;
+        cout << "Ctor: \"" << cstr_ << "\"\n";
     }
+    make_empty();
+    assign_minimum(cstr_, strlen(cstr_));
 }
-// The copy constructor initializes this String with the original's data,
-// and gets minimum allocation.
+// The copy constructor initializes this String with the original's data;
+// it shares the original's allocated memory if it can, otherwise it gets minimum allocation.
 String::String(const String& original)
 {
-    number++;
-    if (messages_wanted)
+    if (counters_compiled)
+    {
+        number++;
+    }
+    if (messages_compiled && messages_wanted)
     {
         cout << "Copy ctor: \"" << original << "\"\n";
     }
-    allocation = original.length + 1;
-    data = allocate(allocation);
-    strcpy(data, original.data);
-    length = original.length;
+    make_empty();
+    if (!original.is_inline() && original.header()->shareable)
+    {
+        original.header()->references.fetch_add(1, std::memory_order_relaxed);
+        data = original.data;
+        length = original.length;
+        allocation = original.allocation;
+    }
+    else
+    {
+        assign_minimum(original.data, original.length);
+    }
+    if (!(original.cache_flags & uncacheable))
+    {
+        prefix = original.prefix;
+        hash_code = original.hash_code;
+        cache_flags = original.cache_flags;
+    }
 }
 // Move constructor - take original's data, and set the original String
 // member variables to the empty state (do not initialize "this" String and swap).
+// Contents in the original's inline buffer are copied into this one's.
 String::String(String&& original) noexcept
 {
-    number++;
-    if (messages_wanted)
+    if (counters_compiled)
+    {
+        number++;
+    }
+    if (messages_compiled && messages_wanted)
     {
         cout << "Move ctor: \"" << original << "\"\n";
     }
-    swap(original);
-    original.data = &a_null_byte;
-    original.allocation = 0;
-    original.length = 0;
+    if (original.is_inline())
+    {
+        memcpy(inline_buffer, original.inline_buffer, original.length + 1);
+        data = inline_buffer;
+    }
+    else
+    {
+        data = original.data;
+    }
+    length = original.length;
+    allocation = original.allocation;
+    prefix = original.prefix;
+    hash_code = original.hash_code;
+    cache_flags = original.cache_flags;
+    original.make_empty();
 }
 // deallocate C-string memory
 String::~String() noexcept
 {
-    number--;
-    if (messages_wanted)
+    if (counters_compiled)
     {
-        cout << "Dtor: \"";
-        if (allocation > 0)
-        {
-            cout << data;
-        }
-        cout << "\"\n"; // ***
+        number--;
+    }
+    if (messages_compiled && messages_wanted)
+    {
+        cout << "Dtor: \"" << data << "\"\n";
     }
     deconstruct();
 }
 
 // Assignment operators
-// Left-hand side gets a copy of rhs data and gets minimum allocation.
+// Left-hand side gets a copy of rhs data, as for the copy constructor.
 // This operator use the copy-swap idiom for assignment.
 String& String::operator= (const String& rhs)
 {
-    if (messages_wanted)
+    if (messages_compiled && messages_wanted)
     {
         cout << "Copy assign from String:  \"" << rhs << "\"\n";
     }
@@ -144,7 +390,7 @@ String& String::operator= (const String& rhs)
 // This operator creates a temporary String object from the rhs C-string, and swaps the contents
 String& String::operator= (const char* rhs)
 {
-    if (messages_wanted)
+    if (messages_compiled && messages_wanted)
     {
         cout << "Assign from C-string:  \"" << rhs << "\"\n";
     }
@@ -155,7 +401,7 @@ String& String::operator= (const char* rhs)
 // Move assignment - simply swaps contents with rhs without any copying
 String& String::operator= (String&& rhs) noexcept
 {
-    if (messages_wanted)
+    if (messages_compiled && messages_wanted)
     {
         cout << "Move assign from String:  \"" << rhs << "\"\n";
     }
@@ -173,11 +419,17 @@ void String::check_subscript(int i) const
         throw String_exception("Subscript out of range");
     }
 }
-// Return a reference to character i in the string.
+// Return a reference to character i in the string; the String stops sharing its memory.
 // Throw exception if 0 <= i < size is false.
 char& String::operator[] (int i)
 {
     check_subscript(i);
+    make_unique();
+    if (!is_inline())
+    {
+        header()->shareable = false;
+    }
+    cache_flags = uncacheable;
     return data[i];
 }
 const char& String::operator[] (int i) const    // const version for const Strings
@@ -200,10 +452,7 @@ String String::substring(int i, int len) const
         throw String_exception("Substring bounds invalid");
     }
     String result;
-    result.allocation = len + 1;
-    result.data = result.allocate(result.allocation);
-    strncpy(result.data, data + i, len);
-    result.length = len;
+    result.assign_minimum(data + i, len);
     return result;
 }
 
@@ -215,6 +464,34 @@ void String::clear()
     swap(empty);
 }
 
+// Return the index of the first occurrence of c at or after index start, or -1 if there is none.
+// Throw exception if 0 <= start <= size is false.
+int String::find(char c, int start) const
+{
+    if (!(start >= 0 && start <= length))
+    {
+        throw String_exception("Find start out of range");
+    }
+    int i = start + String_simd::find_char(data + start, length - start, c);
+    return (i < length) ? i : -1;
+}
+
+// Return the index of the first occurrence of s at or after index start, or -1 if there is none;
+// an empty s is found at start. Throw exception if 0 <= start <= size is false.
+int String::find(const String& s, int start) const
+{
+    if (!(start >= 0 && start <= length))
+    {
+        throw String_exception("Find start out of range");
+    }
+    if (s.length == 0)
+    {
+        return start;
+    }
+    int i = start + String_simd::find_chars(data + start, length - start, s.data, s.length);
+    return (i < length) ? i : -1;
+}
+
 /* Remove the len characters starting at i; allocation is unchanged.
 The removed characters must be contained within the String.
 Valid values for i and len are the same as for substring. */
@@ -224,8 +501,36 @@ void String::remove(int i, int len)
     {
         throw String_exception("Remove bounds invalid");
     }
+    make_unique();
     memmove(data + i, data + i + len, length - (i + len) + 1);
-    length -= len;
+    set_length(length - len);
+    discard_cache();
+}
+
+/* Remove the whitespace characters (as defined by std::isspace) at the beginning and end,
+and replace each run of whitespace characters inside the String with the first
+character of the run; allocation is unchanged. */
+void String::normalize_spaces()
+{
+    make_unique();
+    int kept = 0;
+    int i = String_simd::skip_space(data, length);
+    while (i < length)
+    {
+        // copy the word starting at i, then the first whitespace character after it
+        // unless the whitespace runs to the end
+        int space = i + String_simd::find_space(data + i, length - i);
+        memmove(data + kept, data + i, space - i);
+        kept += space - i;
+        i = (space < length) ? space + String_simd::skip_space(data + space, length - space) : length;
+        if (i < length)
+        {
+            data[kept++] = data[space];
+        }
+    }
+    data[kept] = '\0';
+    set_length(kept);
+    discard_cache();
 }
 
 /* Insert the supplied source String before character i of this String,
@@ -248,9 +553,10 @@ void String::insert_before(int i, const String& src)
         return;
     }
     resize(src.length);
-    memmove(data + i + src.length, data + i, length - i);
-    strncpy(data + i, src.data, src.length);
-    length += src.length;
+    memmove(data + i + src.length, data + i, length - i + 1);
+    memcpy(data + i, src.data, src.length);
+    set_length(length + src.length);
+    discard_cache();
 }
 
 /* These concatenation operators add the rhs string data to the lhs object.
@@ -262,61 +568,237 @@ no change is made to lhs String. */
 String& String::operator += (char rhs)
 {
     resize(1);
-    data[length++] = rhs;
+    data[length] = rhs;
+    data[length + 1] = '\0';
+    set_length(length + 1);
+    discard_cache();
     return *this;
 }
 String& String::operator += (const char* rhs)
 {
     int added_size = strlen(rhs);
     resize(added_size);
-    strcpy(data + length, rhs);
-    length += added_size;
+    memcpy(data + length, rhs, added_size + 1);
+    set_length(length + added_size);
+    discard_cache();
     return *this;
 }
 String& String::operator += (const String& rhs)
 {
     resize(rhs.length);
-    strcpy(data + length, rhs.data);
-    length += rhs.length;
+    memcpy(data + length, rhs.data, rhs.length + 1);
+    set_length(length + rhs.length);
+    discard_cache();
     return *this;
 }
 
+/* Add the n characters starting at s to the end of this String. The final allocation
+is the same as if they were added one at a time with += (char), but at most one
+reallocation is done. */
+String& String::append(const char* s, int n)
+{
+    assert(n >= 0);
+    int needed = length + n + 1;
+    int capacity = get_capacity();
+    if (capacity >= needed)
+    {
+        make_unique();
+    }
+    else
+    {
+        // each += (char) that finds the String full reallocates to hold capacity + 1
+        while (capacity < needed)
+        {
+            capacity = growth_policy(capacity + 1);
+        }
+        reallocate(capacity);
+    }
+    memcpy(data + length, s, n);
+    data[length + n] = '\0';
+    set_length(length + n);
+    discard_cache();
+    return *this;
+}
+
+// The two-digit decimal numbers 00 through 99, for formatting two digits at a time
+const char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Add the decimal digits of value, after a '-' if it is negative, following the doubling rule
+String& String::append(int value)
+{
+    char digits[max_int_chars];
+    return append(digits, format_int(digits, value));
+}
+
+/* Write the decimal digits of value, after a '-' if it is negative, to s, which must have
+room for max_int_chars characters; no null byte is added. Return the number of characters.
+The digits are produced two at a time from the right, then copied to s. */
+int String::format_int(char* s, int value)
+{
+    char digits[max_int_chars];
+    int i = max_int_chars;
+    unsigned int magnitude = (value < 0) ? 0u - static_cast<unsigned int>(value) : value;
+    while (magnitude >= 100)
+    {
+        int pair = 2 * (magnitude % 100);
+        magnitude /= 100;
+        digits[--i] = digit_pairs[pair + 1];
+        digits[--i] = digit_pairs[pair];
+    }
+    if (magnitude >= 10)
+    {
+        digits[--i] = digit_pairs[2 * magnitude + 1];
+        digits[--i] = digit_pairs[2 * magnitude];
+    }
+    else
+    {
+        digits[--i] = '0' + magnitude;
+    }
+    if (value < 0)
+    {
+        digits[--i] = '-';
+    }
+    memcpy(s, digits + i, max_int_chars - i);
+    return max_int_chars - i;
+}
+
+/* Parse an int at the start of the n characters at s: an optional sign followed by
+decimal digits. Return the number of characters used and set value,
+or return 0 if there are no digits or the number does not fit in an int. */
+int String::parse_int(const char* s, int n, int& value)
+{
+    int i = 0;
+    bool negative = false;
+    if (n > 0 && (s[0] == '-' || s[0] == '+'))
+    {
+        negative = (s[0] == '-');
+        i++;
+    }
+    int first_digit = i;
+    // the magnitude of the most negative int is one more than that of the largest
+    const std::uint64_t limit = negative ? 2147483648u : 2147483647u;
+    std::uint64_t magnitude = 0;
+    for (; i < n; i++)
+    {
+        unsigned int digit = static_cast<unsigned char>(s[i]) - '0';
+        if (digit > 9)
+        {
+            break;
+        }
+        magnitude = magnitude * 10 + digit;
+        if (magnitude > limit)
+        {
+            return 0;
+        }
+    }
+    if (i == first_digit)
+    {
+        return 0;
+    }
+    value = negative ? static_cast<int>(-static_cast<std::int64_t>(magnitude)) : static_cast<int>(magnitude);
+    return i;
+}
+
+/* Make the capacity at least n + 1, so that this String can hold n characters without
+reallocating; if more memory is needed, exactly n + 1 bytes are allocated.
+Throw exception if n is negative. */
+void String::reserve(int n)
+{
+    if (n < 0)
+    {
+        throw String_exception("Reserve size invalid");
+    }
+    if (get_capacity() < n + 1)
+    {
+        reallocate(n + 1);
+    }
+}
+
+// Reduce this String to the minimum allocation for its contents
+void String::shrink_to_fit()
+{
+    if (is_inline())
+    {
+        return;
+    }
+    if (length < inline_capacity)
+    {
+        char contents[inline_capacity];
+        int old_length = length;
+        memcpy(contents, data, length + 1);
+        deconstruct();
+        memcpy(inline_buffer, contents, old_length + 1);
+        length = old_length;
+    }
+    else if (allocation > length + 1)
+    {
+        reallocate(length + 1);
+    }
+}
+
 /* Swap the contents of this String with another one.
 The member variable values are interchanged, along with the
-pointers to the allocated C-strings, but the two C-strings
-are neither copied nor modified. No memory allocation/deallocation is done. */
+pointers to the allocated C-strings, but the allocated C-strings
+are neither copied nor modified; the inline buffers are exchanged.
+No memory allocation/deallocation is done. */
 void String::swap(String& other) noexcept
 {
-    char* temp_data = data;
+    if (this == &other)
+    {
+        return;
+    }
+    char temp_buffer[inline_capacity];
+    memcpy(temp_buffer, inline_buffer, inline_capacity);
+    memcpy(inline_buffer, other.inline_buffer, inline_capacity);
+    memcpy(other.inline_buffer, temp_buffer, inline_capacity);
+    char* temp_data = is_inline() ? other.inline_buffer : data;
     int temp_length = length;
     int temp_alloc = allocation;
-    data = other.data;
+    data = other.is_inline() ? inline_buffer : other.data;
     length = other.length;
     allocation = other.allocation;
     other.data = temp_data;
     other.length = temp_length;
     other.allocation = temp_alloc;
+    std::swap(prefix, other.prefix);
+    std::swap(hash_code, other.hash_code);
+    std::swap(cache_flags, other.cache_flags);
 }
 
 // non-member overloaded operators
 
 // compare lhs and rhs strings; constructor will convert a C-string literal to a String.
-// comparison is based on strcmp result compared to 0
+// Strings of different lengths are unequal, as are Strings with different cached
+// prefixes or hash codes; otherwise the characters are compared.
+// The ordering is based on the String::compare result compared to 0.
 bool operator== (const String& lhs, const String& rhs)
 {
-    return strcmp(lhs.c_str(), rhs.c_str()) == 0;
+    if (lhs.size() != rhs.size() || lhs.get_prefix() != rhs.get_prefix())
+    {
+        return false;
+    }
+    if (lhs.has_hash() && rhs.has_hash() && lhs.get_hash() != rhs.get_hash())
+    {
+        return false;
+    }
+    return String_simd::find_mismatch(lhs.c_str(), rhs.c_str(), lhs.size()) == lhs.size();
 }
 bool operator!= (const String& lhs, const String& rhs)
 {
-    return strcmp(lhs.c_str(), rhs.c_str()) != 0;
+    return !(lhs == rhs);
 }
 bool operator< (const String& lhs, const String& rhs)
 {
-    return strcmp(lhs.c_str(), rhs.c_str()) < 0;
+    return lhs.compare(rhs) < 0;
 }
 bool operator> (const String& lhs, const String& rhs)
 {
-    return strcmp(lhs.c_str(), rhs.c_str()) > 0;
+    return lhs.compare(rhs) > 0;
 }
 
 /* Concatenate a String with another String.
@@ -331,6 +813,14 @@ String operator+ (const String& lhs, const String& rhs)
     sum += rhs;
     return sum;
 }
+/* If the lhs is a temporary, such as the result of another +, no copy is made:
+ the rhs is concatenated onto the lhs itself with operator +=, and the lhs is moved
+ into the result, so a chain like a + b + c keeps growing one String. */
+String operator+ (String&& lhs, const String& rhs)
+{
+    lhs += rhs;
+    return std::move(lhs);
+}
 
 // Input and output operators and functions
 // The output operator writes the contents of the String to the stream
@@ -340,63 +830,114 @@ ostream& operator<< (ostream& os, const String& str)
     return os;
 }
 
+namespace {
+
+/* Move through the characters of buf up to the first one for which is_stop is true,
+appending them to str if str is not null, and leave that character in buf.
+The characters are gathered into runs that are appended together, so str grows
+a run at a time rather than a character at a time.
+Return false if the end of input is reached first. */
+bool read_until(streambuf* buf, String* str, bool (*is_stop)(char c))
+{
+    const int run_size = 64;
+    char run[run_size];
+    int n = 0;
+    bool found = false;
+    for (int next = buf->sgetc(); next != char_traits<char>::eof(); next = buf->snextc())
+    {
+        char c = char_traits<char>::to_char_type(next);
+        if (is_stop(c))
+        {
+            found = true;
+            break;
+        }
+        if (str)
+        {
+            run[n++] = c;
+            if (n == run_size)
+            {
+                str->append(run, n);
+                n = 0;
+            }
+        }
+    }
+    if (n > 0)
+    {
+        str->append(run, n);
+    }
+    return found;
+}
+
+// true if c is a whitespace character in the "C" locale
+bool is_space(char c)
+{
+    return c == ' ' || static_cast<unsigned char>(c - '\t') < 5;
+}
+
+bool is_not_space(char c)
+{
+    return !is_space(c);
+}
+
+bool is_newline(char c)
+{
+    return c == '\n';
+}
+
+// Handle a stream that was not ready for input: a stream at its end is left failed,
+// with the eof state cleared; otherwise an exception with the message is thrown.
+void input_not_ready(istream& is, const char* message)
+{
+    if (!is.eof())
+    {
+        throw String_exception(message);
+    }
+    is.clear((is.rdstate() & ~ios::eofbit) | ios::failbit);
+}
+
+}
+
 /* The input operator clears the supplied String, then starts reading the stream.
 It skips initial whitespace, then copies characters into
 the supplied str until whitespace is encountered again. The terminating
 whitespace remains in the input stream, analogous to how string input normally works.
 str is expanded as needed, and retains the final allocation.
-If the input stream fails, str contains whatever characters were read. */
+If the input stream fails, str contains whatever characters were read.
+The characters are read through the stream's buffer and appended to str in runs. */
 istream& operator>> (istream& is, String& str)
 {
     str.clear();
-    bool leading = true;
-    bool trailing = false;
-    while (leading || !trailing)
+    istream::sentry ready(is, true);
+    if (!ready)
     {
-        char next;
-        if (!(is.get(next)))
-        {
-            if (is.eof()) break;
-            throw String_exception(">> error");
-        }
-        if (!isspace(next))
-        {
-            str += next;
-            leading = false;
-        }
-        else
-        {
-            if (!leading) trailing = true;
-        }
+        input_not_ready(is, ">> error");
+        return is;
+    }
+    if (!read_until(is.rdbuf(), nullptr, is_not_space) ||
+        !read_until(is.rdbuf(), &str, is_space))
+    {
+        is.setstate(ios::failbit);
     }
-    is.unget();
     return is;
 }
 
 /* getline for String clears str to an empty String, then reads characters into str until it finds a '\n',
 which is left in the stream (this differs from the fgets and getline functions).
 str's allocation is expanded as needed, and it retains the final allocation.
-If the input stream fails, str contains whatever characters were read. */
+If the input stream fails, str contains whatever characters were read.
+The characters are read through the stream's buffer and appended to str in runs. */
 istream& getline(istream& is, String& str)
 {
     str.clear();
-    while (true)
+    istream::sentry ready(is, true);
+    if (!ready)
     {
-        char next;
-        if (!(is.get(next)))
-        {
-            if (is.eof()) break;
-            throw String_exception("getline failure");
-        }
-        if (next != '\n')
-        {
-            str += next;
-        }
-        else
-        {
-            break;
-        }
+        input_not_ready(is, "getline failure");
+        return is;
+    }
+    if (!read_until(is.rdbuf(), &str, is_newline))
+    {
+        is.setstate(ios::failbit);
     }
-    is.unget();
     return is;
 }
\ No newline at end of file
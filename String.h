@@ -3,27 +3,40 @@
 
 #include <istream>
 #include <ostream>
+#include <cstdint>
+#include <cstring>
 
 /*
 String class - a subset of the C++ Standard Library <string> class
-String objects contain a C-string in a dynamically allocated piece of memory and 
-support input/output, comparisons, copy/move construction and assignment, 
-concatenation, access to individual characters and substrings, and insertion and removal
-of parts of the string. 
+String objects contain a C-string, either in a small buffer inside the String object
+itself or in a dynamically allocated piece of memory, and support input/output, 
+comparisons, copy/move construction and assignment, concatenation, access to individual
+characters and substrings, and insertion and removal of parts of the string. 
 
 Individual characters in the string are indexed the same as an array, 0 through length - 1.
 The "size" of the string is the length of the internal C-string, as defined by std::strlen
-and does not count the null byte marking the end of the C-string. The "allocation" does 
-count the null byte. Thus allocation must be >= size + 1.
+and does not count the null byte marking the end of the C-string. The "allocation" is the 
+amount of dynamically allocated memory and does count the null byte. Thus a String with
+an allocation must have allocation >= size + 1.
+
+Short strings are common, so each String has an inline buffer that holds up to 
+inline_capacity - 1 characters plus the null byte, and needs no dynamic memory at all.
+A String that uses its inline buffer has an allocation of 0, and the "capacity" of a String
+is the size of its inline buffer or its allocation, whichever it is using.
 
 Many operations result in a string that occupies the minimum amount of memory
-(allocation = size + 1), but for efficiency, the operations that involve adding characters
+(the inline buffer if the contents fit in it, otherwise allocation = size + 1), 
+but for efficiency, the operations that involve adding characters
 to the string such as += use a doubling rule for allocation to avoid frequent reallocation
 of memory and data copying.
 
-The doubling rule: If n characters are to be added to a string, and the current allocation
-is  not large enough to hold the result (allocation < size + n + 1), a new piece of memory
+The doubling rule: If n characters are to be added to a string, and the current capacity
+is  not large enough to hold the result (capacity < size + n + 1), a new piece of memory
 is allocated whose size is 2 * (size + n + 1).
+The doubling rule is the default growth policy; a program can install a different policy
+that decides how big the new piece of memory is. Callers that know how many characters
+a String will hold can reserve the memory in advance, and a String that is done growing
+can be trimmed to its minimum allocation with shrink_to_fit.
 
 The doubling rule is a way to prevent excessive reallocation and copying work as 
 the internal contents of a String are expanded - thus it only applies in cases where 
@@ -36,11 +49,37 @@ and the function getline, will then also follow the doubling rule as a result.
 * All other functions and operators either leave the allocation unchanged from the source
 (e.g. swap, copy/move assignment) or result in the minimum allocation (size +1).
 
+Allocated memory is shared between copies (copy-on-write). Copying a String that has an 
+allocation does not copy its characters; the copy refers to the same piece of memory,
+which keeps an atomic count of the Strings referring to it and is deallocated when the
+last of them lets go of it. The characters are copied only when one of the Strings
+is about to be modified (by the non-const operator[], +=, remove, insert_before, 
+or input), and the modified String then gets a private piece of memory with the same
+allocation. A copy thus has the same allocation as its original, and shared memory is
+counted only once in the total allocation. Because a reference returned by the non-const
+operator[] could be used to modify the characters later, a String that has handed one
+out no longer shares its memory with new copies; they get minimum allocation instead.
+
+Comparisons use the known lengths of the strings rather than scanning for null bytes.
+To make most ordering decisions quick, a String caches the big-endian integer value of its
+first 8 characters (padded with zero bytes) the first time it is compared, so comparing two
+Strings usually takes a single integer comparison; the rest of the characters are compared
+only if the first 8 are the same. A String can also cache a hash code of its contents.
+The cached values are discarded whenever the contents change. A String that has handed out
+a reference with the non-const operator[] does not cache anything, because the characters
+could be changed through the reference without the String knowing.
+
+Searching, comparing, and whitespace scanning are done with the kernels in String_simd.h,
+which examine many characters at once.
+
 For those operations that involve indexing into the string such as operator[],
 a String_exception is thrown with an error message if the index is not within a valid range.
 
 For testing and demonstration purposes, this class contains static members that record the 
-current number of Strings in existence and their total memory allocation. 
+current number of Strings in existence and their total dynamic memory allocation,
+along with statistics for sizing memory budgets: how much of the allocation is slack
+(not holding characters or null bytes), the peak total allocation, the numbers of
+allocations and deallocations, and a histogram of the allocation sizes. 
 If the messages_wanted variable is true, the constructors, destructor, and assignment operators
 output a message to demonstrate when these functions are called. The message is output
 before the function does the actual work.  To help identify the String involved,
@@ -51,6 +90,11 @@ the message includes the relevant string data as follows:
 Note that only these functions output the messages. Other member functions may result 
 in these messages being output, but only because they call a constructor, destructor, 
 or assignment operator as part of their work.
+
+The monitoring costs time in every constructor, destructor, and assignment, so each part
+of it can be left out when String.cpp is compiled: defining STRING_NO_MESSAGES removes the
+messages, and defining STRING_NO_COUNTERS removes the counts and statistics, which are then
+reported as zero. The demonstration programs use the default, full monitoring.
 */
 
 // Simple exception class for reporting String errors
@@ -66,8 +110,8 @@ public:
 	// Default initialization is to contain an empty string with no allocation.
     // If a non-empty C-string is supplied, this String gets minimum allocation.
 	String(const char* cstr_ = "");
-	// The copy constructor initializes this String with the original's data,
-	// and gets minimum allocation.
+	// The copy constructor initializes this String with the original's data;
+	// it shares the original's allocated memory if it can, otherwise it gets minimum allocation.
 	String(const String& original);
     // Move constructor - take original's data, and set the original String
     // member variables to the empty state (do not initialize "this" String and swap). 
@@ -76,7 +120,7 @@ public:
 	~String() noexcept;
 	
 	// Assignment operators
-	// Left-hand side gets a copy of rhs data and gets minimum allocation.
+	// Left-hand side gets a copy of rhs data, as for the copy constructor.
 	// This operator use the copy-swap idiom for assignment.
 	String& operator= (const String& rhs);
  	// This operator creates a temporary String object from the rhs C-string, and swaps the contents
@@ -91,16 +135,42 @@ public:
 	// Return size (length) of internal C-string in this String
 	int size() const
 		{return length;}
-	// Return current allocation for this String
+	// Return current allocation for this String; 0 if it is using its inline buffer
 	int get_allocation() const
 		{return allocation;}
+	// Return the number of bytes this String can hold without reallocating,
+    // including the null byte
+	int get_capacity() const
+		{return is_inline() ? inline_capacity : allocation;}
 		
-	// Return a reference to character i in the string.
+	// Return a reference to character i in the string; the String stops sharing its memory.
 	// Throw exception if 0 <= i < size is false.
 	char& operator[] (int i);
 	const char& operator[] (int i) const;	// const version for const Strings
 
 	
+	// Return a value less than, equal to, or greater than zero, as this String
+    // comes before, is equal to, or comes after rhs in the order used by operator<
+	int compare(const String& rhs) const;
+
+	// Return the first 8 characters as a big-endian integer, padded with zero bytes;
+    // integer order of these values agrees with the order of the Strings
+	std::uint64_t get_prefix() const;
+
+	// Return a hash code for the contents (FNV-1a)
+	unsigned int get_hash() const;
+
+	// Return true if a hash code has already been computed and cached
+	bool has_hash() const
+		{return cache_flags & hash_valid;}
+
+	// Return the index of the first occurrence of c at or after index start, or -1 if there is none.
+	// Throw exception if 0 <= start <= size is false.
+	int find(char c, int start = 0) const;
+	// Return the index of the first occurrence of s at or after index start, or -1 if there is none;
+	// an empty s is found at start. Throw exception if 0 <= start <= size is false.
+	int find(const String& s, int start = 0) const;
+
 	/* Return a String starting with i and extending for len characters
 	The substring must be contained within the string.
 	Values of i and len for valid input are as follows:
@@ -128,6 +198,11 @@ public:
 	Throw exception if 0 <= i <= size is false. */
 	void insert_before(int i, const String& src);
 
+	/* Remove the whitespace characters (as defined by std::isspace) at the beginning and end,
+	and replace each run of whitespace characters inside the String with the first
+	character of the run; allocation is unchanged. */
+	void normalize_spaces();
+
 	/* These concatenation operators add the rhs string data to the lhs object.
 	They do not create any temporary String objects. They either directly copy the rhs data
 	into the lhs space if it is big enough to hold the rhs, or allocate new space
@@ -138,10 +213,57 @@ public:
 	String& operator += (const char* rhs);
 	String& operator += (const String& rhs);
 
+	/* Add the n characters starting at s to the end of this String. The final allocation
+	is the same as if they were added one at a time with += (char), but at most one
+	reallocation is done. */
+	String& append(const char* s, int n);
+	// Add the decimal digits of value, after a '-' if it is negative, following the doubling rule
+	String& append(int value);
+
+	// The most characters format_int writes: a sign and 10 digits
+	static const int max_int_chars = 11;
+	/* Write the decimal digits of value, after a '-' if it is negative, to s, which must have
+	room for max_int_chars characters; no null byte is added. Return the number of characters. */
+	static int format_int(char* s, int value);
+
+	/* Parse an int at the start of the n characters at s: an optional sign followed by
+	decimal digits. Return the number of characters used and set value,
+	or return 0 if there are no digits or the number does not fit in an int. */
+	static int parse_int(const char* s, int n, int& value);
+	// Return true and set value if this String consists of an int as parse_int reads it
+	bool parse_int(int& value) const
+		{return length > 0 && parse_int(data, length, value) == length;}
+
+	/* Make the capacity at least n + 1, so that this String can hold n characters without
+	reallocating; if more memory is needed, exactly n + 1 bytes are allocated.
+	Throw exception if n is negative. */
+	void reserve(int n);
+
+	// Reduce this String to the minimum allocation for its contents
+	void shrink_to_fit();
+
+	/* A growth policy returns the allocation to use when a String has to grow to hold
+	needed bytes, including the null byte; the result must be at least needed.
+	The policy is used by the operations that follow the doubling rule. */
+	typedef int (*Growth_policy)(int needed);
+	// The default growth policy, the doubling rule
+	static int double_growth(int needed)
+		{return 2 * needed;}
+	// Set the growth policy for all Strings
+	static void set_growth_policy(Growth_policy policy)
+		{growth_policy = policy;}
+
+	/* Return a String holding the concatenation of the pieces, each a String, C-string, or char.
+	All of the pieces are measured first, and the result is built with a single allocation of
+	exactly the size needed, or none if it fits in the inline buffer. */
+	template<typename... Pieces>
+	static String concatenate(const Pieces&... pieces);
+
 	/* Swap the contents of this String with another one.
 	The member variable values are interchanged, along with the
-	pointers to the allocated C-strings, but the two C-strings
-	are neither copied nor modified. No memory allocation/deallocation is done. */
+	pointers to the allocated C-strings, but the allocated C-strings
+	are neither copied nor modified; the inline buffers are exchanged.
+	No memory allocation/deallocation is done. */
 	void swap(String& other) noexcept;
 	
 	/* Monitoring functions - not part of a normal implementation */
@@ -153,36 +275,106 @@ public:
 	// Return total bytes allocated for all Strings in existence
 	static int get_total_allocation()
 		{return total_allocation;}
+	// Return the allocated bytes not holding characters or null bytes (the slack)
+	static int get_total_slack()
+		{return total_allocation - total_used;}
+	// Return the largest total allocation there has been
+	static int get_peak_allocation()
+		{return peak_allocation;}
+	// Return the number of pieces of memory allocated and deallocated so far
+	static long get_allocation_count()
+		{return allocation_count;}
+	static long get_deallocation_count()
+		{return deallocation_count;}
+	// Return the number of seconds since the program started, for computing rates
+	static double get_statistics_seconds();
+	// The pieces of memory in existence are counted in size classes:
+	// class k holds allocations of more than min_class_size << (k - 1) bytes and
+	// at most min_class_size << k bytes, and the last class holds all larger ones too.
+	static const int min_class_size = 32;
+	static const int num_size_classes = 13;
+	// Return the number of pieces of memory in existence in size class k
+	static int get_size_histogram(int k)
+		{return size_histogram[k];}
 	// Call with true to cause ctor, assignment, and dtor messages to be output.
 	// These messages are output from each function before it does anything else.
 	static void set_messages_wanted(bool messages_wanted_)
 		{messages_wanted = messages_wanted_;}
+
+	// size of the inline buffer, including the null byte
+	static const int inline_capacity = 16;
 	
 private:
-	char * data = nullptr;
+	char * data = nullptr;  // points to inline_buffer or to the allocated C-string
     int length = 0;
-    int allocation = 0;
+    int allocation = 0;     // 0 when data points to inline_buffer
+    char inline_buffer[inline_capacity];
+
+    // Cached comparison values, valid as indicated by cache_flags; they are mutable
+    // because they are filled in by const member functions.
+    enum Cache_flags {prefix_valid = 1, hash_valid = 2, uncacheable = 4};
+    mutable std::uint64_t prefix = 0;
+    mutable unsigned int hash_code = 0;
+    mutable unsigned char cache_flags = 0;
 
-    void deconstruct(); // deallocates data
-    char* allocate(int n); // allocates a new char * and keeps track of total_allocation
-    void resize(int n); // resizes the string to handle if the length was increased by n characters
+    void discard_cache()
+        {cache_flags &= uncacheable;}
+    std::uint64_t compute_prefix() const;
+
+    // Allocated memory starts with a header, followed by the C-string that data points to
+    struct Header;
+    static const int header_size;   // size of Header, rounded up to keep the C-string aligned
+    Header* header() const;
+
+    bool is_inline() const
+        {return data == inline_buffer;}
+    void make_empty() noexcept; // sets an empty inline string without deallocating anything
+    void assign_minimum(const char* src, int len); // sets an empty String to src with minimum allocation
+    void deconstruct(); // lets go of data, deallocating it if no other String shares it
+    char* allocate(int n); // allocates a new char * from the allocation policy and keeps track of total_allocation
+    void resize(int n); // resizes the string to handle if the length was increased by n characters, and unshares it
+    void reallocate(int new_alloc); // moves the contents into a new private allocation of new_alloc bytes
+    void set_length(int n);     // sets length, keeping track of the allocated bytes in use
+
+    // the size and characters of each kind of piece for concatenate
+    static int piece_size(const String& s)
+        {return s.length;}
+    static int piece_size(const char* s)
+        {return std::strlen(s);}
+    static int piece_size(char)
+        {return 1;}
+    static const char* piece_data(const String& s)
+        {return s.data;}
+    static const char* piece_data(const char* s)
+        {return s;}
+    static const char* piece_data(const char& c)
+        {return &c;}
+    void make_unique(); // gives this String its own copy of shared memory
 
     void check_subscript(int i) const; // checks the subscript i and throws errors if i is out of bounds
-	
-	static char a_null_byte;	// to hold a null byte for empty string representation
 
 	/* Variables for monitoring functions - not part of a normal implementation. */
 	/* But used here for demonstration and testing purposes. */
 	static int number;				// counts number of String objects in existence
 	static int total_allocation;	// counts total amount of memory allocated
+	static int total_used;          // counts allocated bytes holding characters or the null byte
+	static int peak_allocation;     // largest value of total_allocation so far
+	static long allocation_count;   // counts pieces of memory allocated so far
+	static long deallocation_count; // counts pieces of memory deallocated so far
+	static int size_histogram[num_size_classes];   // counts pieces of memory in existence by size class
+	static int get_size_class(int n);
 	static bool messages_wanted;	// whether to output constructor/destructor/operator= messages, initially false
 
+	static Growth_policy growth_policy;     // decides the allocation when a String grows
+
 };
 
 // non-member overloaded operators
 
 // compare lhs and rhs strings; constructor will convert a C-string literal to a String.
-// comparison is based on std::strcmp result compared to 0
+// Strings of different lengths are unequal, as are Strings with different cached
+// prefixes or hash codes; otherwise the characters are compared.
+// The ordering is based on the String::compare result compared to 0.
 bool operator== (const String& lhs, const String& rhs);
 bool operator!= (const String& lhs, const String& rhs);
 bool operator< (const String& lhs, const String& rhs);
@@ -195,6 +387,29 @@ bool operator> (const String& lhs, const String& rhs);
  This function constructs a copy of the lhs in a local String variable,
  then concatenates the rhs to it with operator +=, and returns it. */
 String operator+ (const String& lhs, const String& rhs);
+/* If the lhs is a temporary, such as the result of another +, no copy is made:
+ the rhs is concatenated onto the lhs itself with operator +=, and the lhs is moved
+ into the result, so a chain like a + b + c keeps growing one String. */
+String operator+ (String&& lhs, const String& rhs);
+
+// The concatenation is done in order, after all the pieces have been measured
+template<typename... Pieces>
+String String::concatenate(const Pieces&... pieces)
+{
+    // the leading 0 keeps the arrays from being empty when there are no pieces
+    int sizes[] = {0, piece_size(pieces)...};
+    int total = 0;
+    for (int size : sizes)
+    {
+        total += size;
+    }
+    String result;
+    result.reserve(total);
+    int i = 1;
+    int appended[] = {0, (result.append(piece_data(pieces), sizes[i++]), 0)...};
+    (void) appended;
+    return result;
+}
 
 // Input and output operators and functions
 // The output operator writes the contents of the String to the stream
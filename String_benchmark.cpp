@@ -0,0 +1,76 @@
+// Time the basic String operations, to show the cost of the monitoring code.
+// Build it with String.cpp compiled both ways (see the benchmark target in the Makefile)
+// and compare the times.
+
+#include "String.h"
+#include <iostream>
+#include <chrono>
+
+using namespace std;
+
+const int repetitions = 2000000;
+
+// Time repetitions calls of the operation and print the average in nanoseconds
+template<typename F>
+void time_operation(const char* name, F operation);
+
+// keeps the results of the operations in use so that they are not optimized away
+int g_sink = 0;
+
+int main()
+{
+	cout << "String operations, " << repetitions << " repetitions each, nanoseconds per operation:\n";
+	String short_string("DVD");
+	String long_string("The Money Pit, a film on videotape");
+
+	time_operation("construct and destroy, short", []() {
+		String s("VHS");
+		g_sink += s.size();
+	});
+	time_operation("construct and destroy, long", []() {
+		String s("The Money Pit, a film on videotape");
+		g_sink += s.size();
+	});
+	time_operation("copy and destroy, short", [&short_string]() {
+		String s(short_string);
+		g_sink += s.size();
+	});
+	time_operation("copy and destroy, long", [&long_string]() {
+		String s(long_string);
+		g_sink += s.size();
+	});
+	time_operation("copy assign", [&long_string]() {
+		String s;
+		s = long_string;
+		g_sink += s.size();
+	});
+	time_operation("move construct and assign", [&long_string]() {
+		String s(long_string);
+		String t(std::move(s));
+		s = std::move(t);
+		g_sink += s.size();
+	});
+	time_operation("append characters", []() {
+		String s;
+		for (int i = 0; i < 20; i++)
+		{
+			s += 'x';
+		}
+		g_sink += s.size();
+	});
+
+	cout << "Strings: " << String::get_number() << " with " << String::get_total_allocation() << " bytes total\n";
+	return g_sink == 0;
+}
+
+template<typename F>
+void time_operation(const char* name, F operation)
+{
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < repetitions; i++)
+	{
+		operation();
+	}
+	chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+	cout << name << ": " << elapsed.count() / repetitions << "\n";
+}
@@ -0,0 +1,93 @@
+#include "String_pool.h"
+#include <new>
+
+namespace {
+
+// Size class k holds pieces of header_room + (min_block << k) bytes, so that the
+// String header and a doubled C-string fill a piece without spilling into the next class
+const int min_block = 32;
+const int num_classes = 12;             // up to 64K bytes
+const int max_free_per_class = 64;      // limit on the pieces held on each free list
+
+// A free piece of memory holds the link to the next one on its free list
+struct Free_block {
+    Free_block* next;
+};
+
+// The free lists for one thread; the destructor returns their memory to the heap.
+struct Free_lists {
+    Free_block* heads[num_classes] = {};
+    int counts[num_classes] = {};
+    ~Free_lists();
+};
+
+// Set when this thread's free lists have been destroyed; Strings that outlive them,
+// such as those in objects destroyed after the thread_local ones, then use the heap
+// directly. A bool needs no destructor, so it stays valid to the end of the thread.
+thread_local bool free_lists_destroyed = false;
+
+Free_lists::~Free_lists()
+{
+    for (int k = 0; k < num_classes; k++)
+    {
+        while (heads[k] != nullptr)
+        {
+            Free_block* block = heads[k];
+            heads[k] = block->next;
+            ::operator delete(block);
+        }
+    }
+    free_lists_destroyed = true;
+}
+
+thread_local Free_lists free_lists;
+
+// Return the number of bytes in a piece of size class k
+int class_size(int k)
+{
+    return String_pool_policy::header_room + (min_block << k);
+}
+
+// Return the size class for a request of n bytes, or num_classes if n is too large for a class
+int size_class(int n)
+{
+    int k = 0;
+    while (k < num_classes && class_size(k) < n)
+    {
+        k++;
+    }
+    return k;
+}
+
+}
+
+char* String_pool_policy::allocate(int n)
+{
+    int k = size_class(n);
+    if (k == num_classes || free_lists_destroyed)
+    {
+        return static_cast<char*>(::operator new(n));
+    }
+    Free_block* block = free_lists.heads[k];
+    if (block != nullptr)
+    {
+        free_lists.heads[k] = block->next;
+        free_lists.counts[k]--;
+        return reinterpret_cast<char*>(block);
+    }
+    return static_cast<char*>(::operator new(class_size(k)));
+}
+
+void String_pool_policy::deallocate(char* p, int n) noexcept
+{
+    int k = size_class(n);
+    if (k == num_classes || free_lists_destroyed || free_lists.counts[k] == max_free_per_class)
+    {
+        ::operator delete(p);
+        return;
+    }
+    Free_block* block = reinterpret_cast<Free_block*>(p);
+    block->next = free_lists.heads[k];
+    free_lists.heads[k] = block;
+    free_lists.counts[k]++;
+}
@@ -0,0 +1,39 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+/* Allocation policies for the memory that holds the C-string of a String.
+A policy is a class with two static member functions:
+    char* allocate(int n) returns a piece of memory of at least n bytes, or throws std::bad_alloc;
+    void deallocate(char* p, int n) releases memory p that was obtained from allocate(n).
+The policy used by String is selected in String.cpp when it is compiled; the pool policy
+is the default, and the heap policy is used if STRING_HEAP_ALLOCATION is defined.
+Neither policy initializes the memory it supplies.
+*/
+
+// Get each piece of memory directly from new[] and release it with delete[].
+struct String_heap_policy {
+    static char* allocate(int n)
+        {return new char[n];}
+    static void deallocate(char* p, int) noexcept
+        {delete[] p;}
+};
+
+/* Recycle pieces of memory through free lists, one per power-of-two size class.
+A request for n bytes is served from the smallest size class that holds n bytes;
+released memory goes onto the free list for its size class instead of back to the heap,
+so the Strings that are repeatedly built and discarded while reading input reuse the
+same memory. Each size class is a power of two plus header_room bytes for the header
+that String puts in front of its C-string, so the doubling rule used by String when it
+grows makes the size classes a good fit. Requests larger than the biggest size class, and releases to a free list that is
+already holding its limit, go directly to the heap.
+The free lists are thread_local, so no locking is needed; memory released by
+a different thread than the one that allocated it simply joins that thread's lists.
+The memory on a thread's free lists is returned to the heap when the thread exits;
+after that, memory is allocated and released directly on the heap. */
+struct String_pool_policy {
+    static const int header_room = 8;   // at least the size of the String header
+    static char* allocate(int n);
+    static void deallocate(char* p, int n) noexcept;
+};
+
+#endif
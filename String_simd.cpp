@@ -0,0 +1,374 @@
+#include "String_simd.h"
+#include <cstring>
+
+// SSE2 is always available on x86-64; AVX2 is used only if the processor has it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define STRING_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// The set of kernels selected for this processor
+struct Kernels {
+    int (*find_char)(const char* s, int n, char c);
+    int (*find_chars)(const char* s, int n, const char* t, int m);
+    int (*find_mismatch)(const char* a, const char* b, int n);
+    int (*find_space)(const char* s, int n);
+    int (*skip_space)(const char* s, int n);
+    const char* version;
+};
+
+// true if c is a whitespace character in the "C" locale
+inline bool is_space(char c)
+{
+    return c == ' ' || static_cast<unsigned char>(c - '\t') < 5;
+}
+
+/* Scalar versions; each starts at index i, so the vector versions can use them
+to finish the characters past their last full block. */
+
+int scalar_find_char(const char* s, int i, int n, char c)
+{
+    for (; i < n && s[i] != c; i++);
+    return i;
+}
+
+int scalar_find_chars(const char* s, int i, int n, const char* t, int m)
+{
+    for (; i + m <= n; i++)
+    {
+        if (s[i] == t[0] && memcmp(s + i, t, m) == 0)
+        {
+            return i;
+        }
+    }
+    return n;
+}
+
+int scalar_find_mismatch(const char* a, const char* b, int i, int n)
+{
+    for (; i < n && a[i] == b[i]; i++);
+    return i;
+}
+
+int scalar_find_space(const char* s, int i, int n)
+{
+    for (; i < n && !is_space(s[i]); i++);
+    return i;
+}
+
+int scalar_skip_space(const char* s, int i, int n)
+{
+    for (; i < n && is_space(s[i]); i++);
+    return i;
+}
+
+// The scalar kernels, used where no vector kernels are available
+#ifndef STRING_SIMD_X86
+
+int scalar_find_char(const char* s, int n, char c)
+{
+    return scalar_find_char(s, 0, n, c);
+}
+
+int scalar_find_chars(const char* s, int n, const char* t, int m)
+{
+    return scalar_find_chars(s, 0, n, t, m);
+}
+
+int scalar_find_mismatch(const char* a, const char* b, int n)
+{
+    return scalar_find_mismatch(a, b, 0, n);
+}
+
+int scalar_find_space(const char* s, int n)
+{
+    return scalar_find_space(s, 0, n);
+}
+
+int scalar_skip_space(const char* s, int n)
+{
+    return scalar_skip_space(s, 0, n);
+}
+
+#endif
+
+#ifdef STRING_SIMD_X86
+
+/* SSE2 versions, 16 characters per block.
+Each block is compared into a bit mask with one bit per character,
+and the lowest set bit gives the index of the first match in the block. */
+
+// one bit set for each whitespace character in the block
+inline unsigned int sse2_space_mask(__m128i block)
+{
+    __m128i spaces = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+    // tab through carriage return are the five codes starting at tab
+    __m128i offsets = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+    __m128i controls = _mm_cmpeq_epi8(_mm_min_epu8(offsets, _mm_set1_epi8(4)), offsets);
+    return _mm_movemask_epi8(_mm_or_si128(spaces, controls));
+}
+
+int sse2_find_char(const char* s, int n, char c)
+{
+    __m128i target = _mm_set1_epi8(c);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, target));
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return scalar_find_char(s, i, n, c);
+}
+
+// candidates are positions where both the first and last characters of t match;
+// only those are checked in full
+int sse2_find_chars(const char* s, int n, const char* t, int m)
+{
+    if (m == 1)
+    {
+        return sse2_find_char(s, n, t[0]);
+    }
+    __m128i first = _mm_set1_epi8(t[0]);
+    __m128i last = _mm_set1_epi8(t[m - 1]);
+    int i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16)
+    {
+        __m128i first_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i last_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + m - 1));
+        unsigned int mask = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(first_block, first), _mm_cmpeq_epi8(last_block, last)));
+        for (; mask != 0; mask &= mask - 1)
+        {
+            int position = i + __builtin_ctz(mask);
+            if (memcmp(s + position + 1, t + 1, m - 2) == 0)
+            {
+                return position;
+            }
+        }
+    }
+    return scalar_find_chars(s, i, n, t, m);
+}
+
+int sse2_find_mismatch(const char* a, const char* b, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i b_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        unsigned int mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(a_block, b_block)) & 0xFFFF;
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return scalar_find_mismatch(a, b, i, n);
+}
+
+int sse2_find_space(const char* s, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        unsigned int mask = sse2_space_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return scalar_find_space(s, i, n);
+}
+
+int sse2_skip_space(const char* s, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        unsigned int mask = ~sse2_space_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i))) & 0xFFFF;
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return scalar_skip_space(s, i, n);
+}
+
+/* AVX2 versions, 32 characters per block, compiled for AVX2 even if the rest
+of the program is not; they are called only if the processor supports AVX2. */
+
+#define STRING_SIMD_AVX2 __attribute__((target("avx2")))
+
+STRING_SIMD_AVX2 inline unsigned int avx2_space_mask(__m256i block)
+{
+    __m256i spaces = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' '));
+    __m256i offsets = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+    __m256i controls = _mm256_cmpeq_epi8(_mm256_min_epu8(offsets, _mm256_set1_epi8(4)), offsets);
+    return _mm256_movemask_epi8(_mm256_or_si256(spaces, controls));
+}
+
+STRING_SIMD_AVX2 int avx2_find_char(const char* s, int n, char c)
+{
+    __m256i target = _mm256_set1_epi8(c);
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, target));
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return scalar_find_char(s, i, n, c);
+}
+
+STRING_SIMD_AVX2 int avx2_find_chars(const char* s, int n, const char* t, int m)
+{
+    if (m == 1)
+    {
+        return avx2_find_char(s, n, t[0]);
+    }
+    __m256i first = _mm256_set1_epi8(t[0]);
+    __m256i last = _mm256_set1_epi8(t[m - 1]);
+    int i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32)
+    {
+        __m256i first_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        __m256i last_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + m - 1));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(first_block, first), _mm256_cmpeq_epi8(last_block, last)));
+        for (; mask != 0; mask &= mask - 1)
+        {
+            int position = i + __builtin_ctz(mask);
+            if (memcmp(s + position + 1, t + 1, m - 2) == 0)
+            {
+                return position;
+            }
+        }
+    }
+    return scalar_find_chars(s, i, n, t, m);
+}
+
+STRING_SIMD_AVX2 int avx2_find_mismatch(const char* a, const char* b, int n)
+{
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i a_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i b_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        unsigned int mask = ~static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a_block, b_block)));
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return scalar_find_mismatch(a, b, i, n);
+}
+
+STRING_SIMD_AVX2 int avx2_find_space(const char* s, int n)
+{
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        unsigned int mask = avx2_space_mask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)));
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return scalar_find_space(s, i, n);
+}
+
+STRING_SIMD_AVX2 int avx2_skip_space(const char* s, int n)
+{
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        unsigned int mask = ~avx2_space_mask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)));
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return scalar_skip_space(s, i, n);
+}
+
+#endif
+
+// Choose the widest kernels this processor supports
+Kernels select_kernels()
+{
+#ifdef STRING_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return Kernels{avx2_find_char, avx2_find_chars, avx2_find_mismatch,
+            avx2_find_space, avx2_skip_space, "avx2"};
+    }
+    return Kernels{sse2_find_char, sse2_find_chars, sse2_find_mismatch,
+        sse2_find_space, sse2_skip_space, "sse2"};
+#else
+    return Kernels{scalar_find_char, scalar_find_chars, scalar_find_mismatch,
+        scalar_find_space, scalar_skip_space, "scalar"};
+#endif
+}
+
+// The kernels are selected the first time any of them is used
+const Kernels& get_kernels()
+{
+    static const Kernels kernels = select_kernels();
+    return kernels;
+}
+
+}
+
+// Return the index of the first occurrence of c in s, or n if there is none
+int String_simd::find_char(const char* s, int n, char c)
+{
+    return get_kernels().find_char(s, n, c);
+}
+
+// Return the index of the first occurrence of the m characters of t in s, or n if there is none;
+// an empty t is found at 0
+int String_simd::find_chars(const char* s, int n, const char* t, int m)
+{
+    if (m == 0)
+    {
+        return 0;
+    }
+    if (m > n)
+    {
+        return n;
+    }
+    return get_kernels().find_chars(s, n, t, m);
+}
+
+// Return the index of the first character where a and b differ, or n if they are the same
+int String_simd::find_mismatch(const char* a, const char* b, int n)
+{
+    return get_kernels().find_mismatch(a, b, n);
+}
+
+// Return the index of the first whitespace character in s, or n if there is none
+int String_simd::find_space(const char* s, int n)
+{
+    return get_kernels().find_space(s, n);
+}
+
+// Return the index of the first character in s that is not whitespace, or n if there is none
+int String_simd::skip_space(const char* s, int n)
+{
+    return get_kernels().skip_space(s, n);
+}
+
+// Return the name of the selected version: "avx2", "sse2", or "scalar"
+const char* String_simd::get_version()
+{
+    return get_kernels().version;
+}
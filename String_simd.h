@@ -0,0 +1,32 @@
+#ifndef STRING_SIMD_H
+#define STRING_SIMD_H
+
+/* Scanning kernels for the characters of a String.
+Each function works on a run of n characters starting at s, and does not depend
+on a null byte at the end of the run. Whitespace means the characters for which
+std::isspace is true in the "C" locale: space, tab, newline, vertical tab, form feed,
+and carriage return.
+
+The kernels examine 16 characters at a time with SSE2 or 32 at a time with AVX2.
+The first call selects the widest version the processor supports; the characters
+past the last full block, and all the characters on processors or compilers without
+these instruction sets, are handled by simple loops. Every version gives the same results.
+*/
+
+struct String_simd {
+    // Return the index of the first occurrence of c in s, or n if there is none
+    static int find_char(const char* s, int n, char c);
+    // Return the index of the first occurrence of the m characters of t in s, or n if there is none;
+    // an empty t is found at 0
+    static int find_chars(const char* s, int n, const char* t, int m);
+    // Return the index of the first character where a and b differ, or n if they are the same
+    static int find_mismatch(const char* a, const char* b, int n);
+    // Return the index of the first whitespace character in s, or n if there is none
+    static int find_space(const char* s, int n);
+    // Return the index of the first character in s that is not whitespace, or n if there is none
+    static int skip_space(const char* s, int n);
+    // Return the name of the selected version: "avx2", "sse2", or "scalar"
+    static const char* get_version();
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef STRING_VIEW_H
+#define STRING_VIEW_H
+
+#include "String.h"
+#include <cstring>
+#include <ostream>
+
+/*
+A String_view refers to a sequence of characters owned by something else, such as a String
+or a C-string, as a pointer and a length, without copying or allocating anything.
+It is used to compare and look up text cheaply. The referred-to characters must outlive
+the String_view and must not be changed while it is in use.
+
+String_views compare in the same order as Strings, i.e. by the values of their characters
+as unsigned chars, a shorter sequence coming before a longer one that starts with it.
+A String converts implicitly to a String_view, so a String_view can be compared with a String.
+*/
+
+class String_view {
+public:
+    // an empty view
+    String_view() :
+        ptr(""), len(0)
+        {}
+    // view of a C-string, not including the null byte
+    String_view(const char* cstr) :
+        ptr(cstr), len(static_cast<int>(std::strlen(cstr)))
+        {}
+    // view of len characters starting at ptr_
+    String_view(const char* ptr_, int len_) :
+        ptr(ptr_), len(len_)
+        {}
+    // view of the contents of a String
+    String_view(const String& str) :
+        ptr(str.c_str()), len(str.size())
+        {}
+
+    // Return a pointer to the first character; the characters are not necessarily null-terminated
+    const char* data() const
+        {return ptr;}
+    int size() const
+        {return len;}
+
+    // Return a value less than, equal to, or greater than zero, as this view
+    // comes before, is equal to, or comes after rhs
+    int compare(String_view rhs) const
+    {
+        int common = (len < rhs.len) ? len : rhs.len;
+        int result = std::memcmp(ptr, rhs.ptr, common);
+        if (result != 0) return result;
+        return len - rhs.len;
+    }
+
+private:
+    const char* ptr;
+    int len;
+};
+
+inline bool operator== (String_view lhs, String_view rhs)
+    {return lhs.size() == rhs.size() && std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;}
+inline bool operator!= (String_view lhs, String_view rhs)
+    {return !(lhs == rhs);}
+inline bool operator< (String_view lhs, String_view rhs)
+    {return lhs.compare(rhs) < 0;}
+inline bool operator> (String_view lhs, String_view rhs)
+    {return lhs.compare(rhs) > 0;}
+
+// The output operator writes the characters of the view to the stream
+inline std::ostream& operator<< (std::ostream& os, String_view view)
+{
+    os.write(view.data(), view.size());
+    return os;
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "Utility.h"
+#include "String.h"
 #include <iostream>
+#include <cctype>
 
 using namespace std;
 
@@ -10,9 +12,33 @@ void throw_file_error()
 
 int integer_read()
 {
+    // read the characters that cin >> would use for an int, then parse them;
+    // the character after them is left in the stream
+    istream::sentry ready(cin);
+    String text;
+    if (ready)
+    {
+        streambuf* buf = cin.rdbuf();
+        int next = buf->sgetc();
+        if (next == '-' || next == '+')
+        {
+            text += char(next);
+            next = buf->snextc();
+        }
+        while (next != char_traits<char>::eof() && isdigit(next))
+        {
+            text += char(next);
+            next = buf->snextc();
+        }
+        if (next == char_traits<char>::eof())
+        {
+            cin.setstate(ios::eofbit);
+        }
+    }
     int integer;
-    if (!(cin >> integer))
+    if (!text.parse_int(integer))
     {
+        cin.setstate(ios::failbit);
         throw Error("Could not read an integer value!");
     }
     return integer;
@@ -2,48 +2,93 @@
 #include <fstream>
 #include <limits>
 #include <istream>
-#include <cctype>
 #include "String.h"
+#include "String_view.h"
 #include "Ordered_list.h"
 #include "Record.h"
+#include "Record_table.h"
 #include "Collection.h"
 #include "Utility.h"
 #include "p2_globals.h"
 
 using namespace std;
 
-struct record_id_comp {
-    bool operator() (const Record *lhs, const Record *rhs) const { return lhs->get_ID() < rhs->get_ID(); }
+// Writes a list of Record or Collection pointers in save format for Ordered_list::serialize
+template<typename T>
+struct Save_writer {
+    Save_writer(ostream& os_) : os(os_) {}
+    void write_count(int n)
+    {
+        char count[String::max_int_chars + 1];
+        int length = String::format_int(count, n);
+        count[length] = '\n';
+        os.write(count, length + 1);
+    }
+    void write(T* item) { item->save(os); }
+    ostream& os;
 };
 
+// Reads Records in save format for Ordered_list::deserialize, adding each to the table by ID
+struct Record_reader {
+    Record_reader(ifstream& is_, Record_table& library_id_) : is(is_), library_id(library_id_) {}
+    int read_count();
+    Record* read();
+    void discard(Record* record);
+    ifstream& is;
+    Record_table& library_id;
+};
+
+// Reads Collections in save format for Ordered_list::deserialize, resolving members in the library
+struct Collection_reader {
+    Collection_reader(ifstream& is_, const Ordered_list<Record*, Less_than_ptr<Record*>>& library_) :
+        is(is_), library(library_) {}
+    int read_count();
+    Collection* read() { return new Collection(is, library); }
+    void discard(Collection* collection) { delete collection; }
+    ifstream& is;
+    const Ordered_list<Record*, Less_than_ptr<Record*>>& library;
+};
+
+int read_file_count(ifstream& is);
+
 void throw_unrecognized_command();
 
 Record* read_title_get_record(Ordered_list<Record*, Less_than_ptr<Record*>>& library_title);
 Ordered_list<Record*, Less_than_ptr<Record*>>::Iterator read_title_get_iter(Ordered_list<Record*, Less_than_ptr<Record*>>& library_title);
 
-Record* read_id_get_record(Ordered_list<Record*, record_id_comp>& library_id);
-Ordered_list<Record*, record_id_comp>::Iterator read_id_get_iter(Ordered_list<Record*, record_id_comp>& library_id);
+Record* read_id_get_record(Record_table& library_id);
 
 Collection* read_name_get_collection(Ordered_list<Collection*, Less_than_ptr<Collection*>>& catalog);
 Ordered_list<Collection*, Less_than_ptr<Collection*>>::Iterator read_name_get_iter(Ordered_list<Collection*, Less_than_ptr<Collection*>>& catalog);
 
-void clear_libraries(Ordered_list<Record*, Less_than_ptr<Record*>>& library_title, Ordered_list<Record*, record_id_comp>& library_id);
+void clear_libraries(Ordered_list<Record*, Less_than_ptr<Record*>>& library_title,
+    Ordered_list<Record*, record_collation_comp>& library_collated, Record_table& library_id);
 void clear_catalog(Ordered_list<Collection*, Less_than_ptr<Collection*>>& catalog);
 
 bool check_collection_not_empty(Collection *collection);
-bool check_record_in_collection(Collection *collection, Record *record);
+
+Id_set combine_members(char action, Collection *first, Collection *second);
+int count_combined_members(char action, Collection *first, Collection *second);
+void add_members_by_ID(Collection *collection, const Id_set& member_IDs,
+    Ordered_list<Record*, Less_than_ptr<Record*>>& library_title, Record_table& library_id);
 
 void print_record(Record* record);
 void print_collection(Collection* collection);
+void print_string_statistics();
 
 String title_read(istream &is);
 String parse_title(String& title_string);
 
 int main()
 {
+    // all console I/O goes through the iostreams, so cin can have its own buffer
+    // for String input to scan instead of going through stdio a character at a time
+    ios::sync_with_stdio(false);
     Ordered_list<Collection*, Less_than_ptr<Collection*>> catalog;
     Ordered_list<Record*, Less_than_ptr<Record*>> library_title;
-    Ordered_list<Record*, record_id_comp> library_id;
+    // the same Records in collation order, for pl
+    Ordered_list<Record*, record_collation_comp> library_collated;
+    Record_table library_id;
     while (true)
     {
         try
@@ -90,6 +135,42 @@ int main()
                             cout << *collection_ptr << "\n";
                             break;
                         }
+                        case 'g': /* print the rating summary of a collection */
+                        {
+                            Collection *collection_ptr = read_name_get_collection(catalog);
+                            int rated = collection_ptr->get_rated_count();
+                            cout << "Collection " << collection_ptr->get_name() << " has " << rated << " rated and "
+                                << collection_ptr->get_rating_count(0) << " unrated members";
+                            if (rated > 0)
+                            {
+                                cout << ", average rating " << collection_ptr->get_average_rating();
+                            }
+                            cout << "\nRatings:";
+                            for (int rating = 1; rating <= Record::max_rating; rating++)
+                            {
+                                cout << " " << rating << ": " << collection_ptr->get_rating_count(rating);
+                            }
+                            cout << "\n";
+                            break;
+                        }
+                        case 'm': /* print the collections a record is a member of */
+                        {
+                            Record *record_ptr = read_id_get_record(library_id);
+                            int count = record_ptr->get_collection_count();
+                            cout << "Record " << record_ptr->get_ID() << " " << record_ptr->get_title();
+                            if (count == 0)
+                            {
+                                cout << " is not a member of any collection\n";
+                                break;
+                            }
+                            cout << " is a member of " << count << " collections:";
+                            for (int i = 0; i < count; i++)
+                            {
+                                cout << " " << record_ptr->get_collection(i)->get_name();
+                            }
+                            cout << "\n";
+                            break;
+                        }
                         case 'L': /* print library */
                         {
                             if (library_title.empty())
@@ -104,6 +185,20 @@ int main()
                             }
                             break;
                         }
+                        case 'l': /* print library in collation order */
+                        {
+                            if (library_collated.empty())
+                            {
+                                cout << "Library is empty\n";
+                            }
+                            else
+                            {
+                                cout << "Library contains " << library_collated.size() << " records:";
+                                apply(library_collated.begin(), library_collated.end(), print_record);
+                                cout << "\n";
+                            }
+                            break;
+                        }
                         case 'C': /* print catalog */
                         {
                             if (catalog.empty())
@@ -128,6 +223,11 @@ int main()
                             cout << "Strings: " << String::get_number() << " with " << String::get_total_allocation() << " bytes total\n";
                             break;
                         }
+                        case 's': /* print String allocation statistics */
+                        {
+                            print_string_statistics();
+                            break;
+                        }
                         default:
                         {
                             throw_unrecognized_command();
@@ -165,14 +265,19 @@ int main()
                             String medium, title;
                             cin >> medium;
                             title = title_read(cin);
-                            Record temp_record(title);
-                            if (library_title.find(&temp_record) != library_title.end())
+                            if (library_title.find(String_view(title)) != library_title.end())
                             {
                                 throw Error("Library already has a record with this title!");
                             }
                             Record *record = new Record(medium, title);
+                            if (record->get_ID() > Record_table::max_ID)
+                            {
+                                delete record;
+                                throw Error("No more record ID numbers are available!");
+                            }
                             library_id.insert(record);
                             library_title.insert(record);
+                            library_collated.insert(record);
                             cout << "Record " << record->get_ID() << " added\n";
                             break;
                         }
@@ -180,8 +285,7 @@ int main()
                         {
                             String name;
                             cin >> name;
-                            Collection temp_collection(name);
-                            if (catalog.find(&temp_collection) != catalog.end())
+                            if (catalog.find(String_view(name)) != catalog.end())
                             {
                                 throw Error("Catalog already has a collection with this name!");
                             }
@@ -212,13 +316,14 @@ int main()
                         case 'r': /* delete record */
                         {
                             auto record_iter = read_title_get_iter(library_title);
-                            if (apply_if_arg(catalog.begin(), catalog.end(), check_record_in_collection, *record_iter))
+                            if ((*record_iter)->get_collection_count() > 0)
                             {
                                 throw Error("Cannot delete a record that is a member of a collection!");
                             }
                             Record *record_ptr = *record_iter;
                             library_title.erase(record_iter);
-                            library_id.erase(library_id.find(record_ptr));
+                            library_collated.erase(library_collated.find(record_ptr));
+                            library_id.erase(record_ptr->get_ID());
                             cout << "Record " << record_ptr->get_ID() << " " << record_ptr->get_title() << " deleted\n";
                             delete record_ptr;
                             break;
@@ -259,7 +364,7 @@ int main()
                                 throw Error("Cannot clear all records unless all collections are empty!");
                             }
                             Record::reset_ID_counter();
-                            clear_libraries(library_title, library_id);
+                            clear_libraries(library_title, library_collated, library_id);
                             cout << "All records deleted\n";
                             break;
                         }
@@ -272,8 +377,8 @@ int main()
                         case 'A': /* clear all */
                         {
                             Record::reset_ID_counter();
-                            clear_libraries(library_title, library_id);
                             clear_catalog(catalog);
+                            clear_libraries(library_title, library_collated, library_id);
                             cout << "All data deleted\n";
                             break;
                         }
@@ -298,16 +403,10 @@ int main()
                             {
                                 throw Error("Could not open file!");
                             }
-                            file << library_title.size() << "\n";
-                            for (auto&& record : library_title)
-                            {
-                                record->save(file);
-                            }
-                            file << catalog.size() << "\n";
-                            for (auto catalog_iter = catalog.begin(); catalog_iter != catalog.end(); ++catalog_iter)
-                            {
-                                (*catalog_iter)->save(file);
-                            }
+                            Save_writer<Record> record_writer(file);
+                            library_title.serialize(record_writer);
+                            Save_writer<Collection> collection_writer(file);
+                            catalog.serialize(collection_writer);
                             cout << "Data saved\n";
                             break;
                         }
@@ -332,43 +431,31 @@ int main()
                             {
                                 throw Error("Could not open file!");
                             }
-                            int num;
-                            file >> num;
                             Ordered_list<Collection*, Less_than_ptr<Collection*>> new_catalog;
                             Ordered_list<Record*, Less_than_ptr<Record*>> new_library_title;
-                            Ordered_list<Record*, record_id_comp> new_library_id;
+                            Ordered_list<Record*, record_collation_comp> new_library_collated;
+                            Record_table new_library_id;
                             try
                             {
                                 Record::save_ID_counter();
                                 Record::reset_ID_counter();
-                                while (num > 0)
-                                {
-                                    Record *record_ptr = new Record(file);
-                                    new_library_title.insert(record_ptr);
-                                    new_library_id.insert(record_ptr);
-                                    num--;
-                                }
-                                if (!(file >> num))
-                                {
-                                    throw_file_error();
-                                }
-                                while (num > 0)
-                                {
-                                    Collection *collection_ptr = new Collection(file, new_library_title);
-                                    new_catalog.insert(collection_ptr);
-                                    num--;
-                                }
-                                clear_libraries(library_title, library_id);
+                                Record_reader record_reader(file, new_library_id);
+                                new_library_title.deserialize(record_reader);
+                                new_library_collated.sort_load(new_library_title.begin(), new_library_title.end());
+                                Collection_reader collection_reader(file, new_library_title);
+                                new_catalog.deserialize(collection_reader);
                                 clear_catalog(catalog);
-                                library_title = new_library_title;
-                                library_id = new_library_id;
-                                catalog = new_catalog;
+                                clear_libraries(library_title, library_collated, library_id);
+                                library_title = std::move(new_library_title);
+                                library_collated = std::move(new_library_collated);
+                                library_id = std::move(new_library_id);
+                                catalog = std::move(new_catalog);
                                 cout << "Data loaded\n";
                             }
                             catch (Error& e)
                             {
                                 clear_catalog(new_catalog);
-                                clear_libraries(new_library_title, new_library_id);
+                                clear_libraries(new_library_title, new_library_collated, new_library_id);
                                 Record::restore_ID_counter();
                                 throw_file_error();
                             }
@@ -382,14 +469,60 @@ int main()
                     }
                     break;
                 }
+                case 'u': /* union of two collections */
+                case 'i': /* intersection of two collections */
+                case 'e': /* difference of two collections: the members of the first except those of the second */
+                {
+                    switch (object)
+                    {
+                        case 'c': /* create a collection from the result */
+                        {
+                            String name;
+                            cin >> name;
+                            if (catalog.find(String_view(name)) != catalog.end())
+                            {
+                                throw Error("Catalog already has a collection with this name!");
+                            }
+                            Collection *first_ptr = read_name_get_collection(catalog);
+                            Collection *second_ptr = read_name_get_collection(catalog);
+                            Id_set member_IDs = combine_members(action, first_ptr, second_ptr);
+                            Collection *collection_ptr = new Collection(name);
+                            try
+                            {
+                                add_members_by_ID(collection_ptr, member_IDs, library_title, library_id);
+                                catalog.insert(collection_ptr);
+                            }
+                            catch (...)
+                            {
+                                delete collection_ptr;
+                                throw;
+                            }
+                            cout << "Collection " << name << " added with " << member_IDs.size() << " members\n";
+                            break;
+                        }
+                        case 'n': /* print the number of records in the result */
+                        {
+                            Collection *first_ptr = read_name_get_collection(catalog);
+                            Collection *second_ptr = read_name_get_collection(catalog);
+                            cout << "Result has " << count_combined_members(action, first_ptr, second_ptr) << " members\n";
+                            break;
+                        }
+                        default:
+                        {
+                            throw_unrecognized_command();
+                            break;
+                        }
+                    }
+                    break;
+                }
                 case 'q': /* quit */
                 {
                     switch (object)
                     {
                         case 'q': /* quit */
                         {
-                            clear_libraries(library_title, library_id);
                             clear_catalog(catalog);
+                            clear_libraries(library_title, library_collated, library_id);
                             cout << "All data deleted\nDone\n";
                             return 0;
                         }
@@ -420,6 +553,48 @@ int main()
     }
 }
 
+int Record_reader::read_count()
+{
+    return read_file_count(is);
+}
+
+// Read a Record and add it to the table; a Record whose ID is not between 1 and
+// Record_table::max_ID, or is already in use, is invalid data
+Record* Record_reader::read()
+{
+    Record* record = new Record(is);
+    if (record->get_ID() <= 0 || record->get_ID() > Record_table::max_ID || library_id.find(record->get_ID()))
+    {
+        delete record;
+        throw_file_error();
+    }
+    library_id.insert(record);
+    return record;
+}
+
+// Take back a Record that could not be added to the list: remove it from the table and delete it
+void Record_reader::discard(Record* record)
+{
+    library_id.erase(record->get_ID());
+    delete record;
+}
+
+int Collection_reader::read_count()
+{
+    return read_file_count(is);
+}
+
+// Read the number of items that follow in a saved file; throw Error exception if it is missing
+int read_file_count(ifstream& is)
+{
+    int num;
+    if (!(is >> num))
+    {
+        throw_file_error();
+    }
+    return num;
+}
+
 void throw_unrecognized_command()
 {
     throw Error("Unrecognized command!");
@@ -433,8 +608,7 @@ Record* read_title_get_record(Ordered_list<Record*, Less_than_ptr<Record*>>& lib
 Ordered_list<Record*, Less_than_ptr<Record*>>::Iterator read_title_get_iter(Ordered_list<Record*, Less_than_ptr<Record*>>& library_title)
 {
     String title = title_read(cin);
-    Record temp_record(title);
-    auto record_iter = library_title.find(&temp_record);
+    auto record_iter = library_title.find(String_view(title));
     if (record_iter == library_title.end())
     {
         throw Error("No record with that title!");
@@ -442,21 +616,15 @@ Ordered_list<Record*, Less_than_ptr<Record*>>::Iterator read_title_get_iter(Orde
     return record_iter;
 }
 
-Record* read_id_get_record(Ordered_list<Record*, record_id_comp>& library_id)
-{
-    return *read_id_get_iter(library_id);
-}
-
-Ordered_list<Record*, record_id_comp>::Iterator read_id_get_iter(Ordered_list<Record*, record_id_comp>& library_id)
+Record* read_id_get_record(Record_table& library_id)
 {
     int id = integer_read();
-    Record temp_record(id);
-    auto record_iter = library_id.find(&temp_record);
-    if (record_iter == library_id.end())
+    Record* record_ptr = library_id.find(id);
+    if (!record_ptr)
     {
         throw Error("No record with that ID!");
     }
-    return record_iter;
+    return record_ptr;
 }
 
 Collection* read_name_get_collection(Ordered_list<Collection*, Less_than_ptr<Collection*>>& catalog)
@@ -468,8 +636,7 @@ Ordered_list<Collection*, Less_than_ptr<Collection*>>::Iterator read_name_get_it
 {
     String name;
     cin >> name;
-    Collection temp_collection(name);
-    auto collection_iter = catalog.find(&temp_collection);
+    auto collection_iter = catalog.find(String_view(name));
     if (collection_iter == catalog.end())
     {
         throw Error("No collection with that name!");
@@ -477,15 +644,16 @@ Ordered_list<Collection*, Less_than_ptr<Collection*>>::Iterator read_name_get_it
     return collection_iter;
 }
 
-void clear_libraries(Ordered_list<Record*, Less_than_ptr<Record*>>& library_title, Ordered_list<Record*, record_id_comp>& library_id)
+// The Records are deleted in ID order, which follows their order in memory
+void clear_libraries(Ordered_list<Record*, Less_than_ptr<Record*>>& library_title,
+    Ordered_list<Record*, record_collation_comp>& library_collated, Record_table& library_id)
 {
-    auto title_iter = library_title.begin();
-    while (title_iter != library_title.end())
+    for (auto id_iter = library_id.begin(); id_iter != library_id.end(); ++id_iter)
     {
-        delete *title_iter;
-        ++title_iter;
+        delete *id_iter;
     }
     library_title.clear();
+    library_collated.clear();
     library_id.clear();
 }
 
@@ -505,9 +673,70 @@ bool check_collection_not_empty(Collection *collection)
     return !(collection->empty());
 }
 
-bool check_record_in_collection(Collection *collection, Record *record)
+// Return the IDs of the members of the union ('u'), intersection ('i'),
+// or difference ('e') of the two collections
+Id_set combine_members(char action, Collection *first, Collection *second)
 {
-    return collection->is_member_present(record);
+    switch (action)
+    {
+        case 'u':
+            return Id_set::set_union(first->get_member_IDs(), second->get_member_IDs());
+        case 'i':
+            return Id_set::set_intersection(first->get_member_IDs(), second->get_member_IDs());
+        default:
+            return Id_set::set_difference(first->get_member_IDs(), second->get_member_IDs());
+    }
+}
+
+// Return the number of members of the union, intersection, or difference
+// of the two collections without forming it
+int count_combined_members(char action, Collection *first, Collection *second)
+{
+    switch (action)
+    {
+        case 'u':
+            return Id_set::union_size(first->get_member_IDs(), second->get_member_IDs());
+        case 'i':
+            return Id_set::intersection_size(first->get_member_IDs(), second->get_member_IDs());
+        default:
+            return Id_set::difference_size(first->get_member_IDs(), second->get_member_IDs());
+    }
+}
+
+// Add the Records with the IDs to the collection. When there are few of them compared to
+// the library, they are looked up by ID and added in ID order, each with a sorted insert.
+// Otherwise the library is walked in title order, so each member goes at the end of the
+// collection's list.
+void add_members_by_ID(Collection *collection, const Id_set& member_IDs,
+    Ordered_list<Record*, Less_than_ptr<Record*>>& library_title, Record_table& library_id)
+{
+    const int walk_ratio = 16;
+    if (member_IDs.size() * walk_ratio < library_title.size())
+    {
+        int *IDs = new int[member_IDs.size()];
+        member_IDs.get_IDs(IDs);
+        try
+        {
+            for (int i = 0; i < member_IDs.size(); i++)
+            {
+                collection->add_member(library_id.find(IDs[i]));
+            }
+        }
+        catch (...)
+        {
+            delete[] IDs;
+            throw;
+        }
+        delete[] IDs;
+        return;
+    }
+    for (auto it = library_title.begin(); it != library_title.end(); ++it)
+    {
+        if (member_IDs.contains((*it)->get_ID()))
+        {
+            collection->add_member(*it);
+        }
+    }
 }
 
 void print_record(Record* record)
@@ -520,6 +749,37 @@ void print_collection(Collection* collection)
     cout << "\n" << *collection;
 }
 
+// prints the String allocation statistics: totals, slack, peak, rates, and size histogram
+void print_string_statistics()
+{
+    double seconds = String::get_statistics_seconds();
+    cout << "String allocations:\n";
+    cout << "Strings: " << String::get_number() << " with " << String::get_total_allocation() << " bytes total, "
+        << String::get_total_slack() << " bytes slack\n";
+    cout << "Peak: " << String::get_peak_allocation() << " bytes\n";
+    cout << "Allocations: " << String::get_allocation_count() << " (" << String::get_allocation_count() / seconds << " per second)\n";
+    cout << "Deallocations: " << String::get_deallocation_count() << " (" << String::get_deallocation_count() / seconds << " per second)\n";
+    cout << "Sizes:";
+    int size = String::min_class_size;
+    for (int k = 0; k < String::num_size_classes; k++, size *= 2)
+    {
+        if (String::get_size_histogram(k) == 0)
+        {
+            continue;
+        }
+        if (k < String::num_size_classes - 1)
+        {
+            cout << "\n  up to " << size << ": ";
+        }
+        else
+        {
+            cout << "\n  over " << size / 2 << ": ";
+        }
+        cout << String::get_size_histogram(k);
+    }
+    cout << "\n";
+}
+
 String title_read(istream &is)
 {
     String title;
@@ -535,29 +795,7 @@ String title_read(istream &is)
 String parse_title(String& title_string)
 {
     String title(title_string);
-    for (int i = 0; i < title.size(); i++)
-    {
-        if (!isspace(title[i]))
-        {
-            title.remove(0, i);
-            break;
-        }
-    }
-    for (int i = 0; i < title.size(); i++)
-    {
-        if (isspace(title[i]))
-        {
-            int j;
-            for (j = i + 1; j < title.size() && isspace(title[j]); j++);
-            if (j != i + 1)
-            {
-                title.remove(i + 1, j - (i + 1));
-            }
-        }
-    }
-    if (title.size() > 0 && isspace(title[title.size() - 1]))
-    {
-        title.remove(title.size() - 1, 1);
-    }
+    title.normalize_spaces();
+    title.shrink_to_fit();
     return title;
 }
\ No newline at end of file